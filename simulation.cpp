@@ -6,6 +6,31 @@
 #include <cmath>
 #include <string>
 #include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <type_traits>
+#include <limits>
+#include <array>
+#if defined(__unix__)
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 constexpr float PI = 3.14159265358979323846f;
 constexpr int WIDTH  = 200;
@@ -16,33 +41,550 @@ constexpr int SEASON_LENGTH = 4 * DAY_LENGTH;
 constexpr int SAVE_INTERVAL = 5;
 constexpr float INITIAL_GRASS_PROB = 0.02f;
 constexpr float MUTATION_STDDEV    = 0.05f;
-constexpr int   RAIN_INTERVAL      = 150;
-constexpr float RAIN_AMOUNT        = 1.0f;
+constexpr float STORM_SPAWN_RATE   = 8e-6f; // expected new storms per tile per tick
+constexpr float STORM_MIN_SIGMA    = 4.0f;  // footprint std-dev range, tiles
+constexpr float STORM_MAX_SIGMA    = 12.0f;
+constexpr float STORM_INTENSITY    = 0.05f; // peak water per tick at the storm centre
+constexpr int   STORM_MIN_LIFE     = 20;
+constexpr int   STORM_MAX_LIFE     = 60;
+constexpr float STORM_SPEED        = 0.5f;  // tiles per tick
 constexpr float REPRODUCE_ENERGY   = 0.55f;
 constexpr float   MATURITY_AGE_SCALE = 0.3f;
+constexpr float HYDRO_DIFFUSION    = 0.05f; // fraction of neighbour gradient moved per tick (<0.25 for stability)
+constexpr float NUTRIENT_DIFFUSION = 0.02f; // same, for soil nutrients (no flux into water tiles)
+constexpr int   NUTRIENT_DIFFUSION_INTERVAL = 5;
+constexpr float LITTER_DECAY_SCALE = 0.02f; // litter fraction released per tick = decayRate * scale
+constexpr float LITTER_EPSILON     = 1e-3f; // below this the remaining litter is released at once
+constexpr int   LIGHT_RADIUS       = 2;     // shading neighbourhood is (2r+1)^2 tiles
+constexpr float LIGHT_COMPETITION  = 0.15f; // light lost per unit of mean neighbour energy
+constexpr float FIRE_LIGHTNING_RATE = 2e-6f; // expected strikes per tile per tick
+constexpr float FIRE_DRY_WATER     = 2.0f;  // only tiles drier than this can burn
+constexpr float FIRE_SPREAD_PROB   = 0.35f; // per burning neighbour, scaled by dryness
+constexpr int   FIRE_BURN_TICKS    = 3;     // ticks a tile keeps burning after ignition
+constexpr float HERBIVORE_DENSITY  = 0.005f; // initial herbivores per soil tile
+constexpr float HERB_SPEED         = 1.0f;  // tiles per tick
+constexpr float HERB_BITE          = 0.15f;  // plant energy eaten per tick
+constexpr float HERB_ASSIMILATION  = 0.8f;  // fraction of eaten energy kept
+constexpr float HERB_METABOLISM    = 0.05f; // energy burned per tick
+constexpr float HERB_REPRODUCE_ENERGY = 20.0f;
+constexpr int   HERB_MAX_AGE       = 400;
+constexpr float HERB_CROWD_RADIUS  = 2.0f;  // separation radius, also the spatial hash cell size
+constexpr int   HERB_CROWD_MAX     = 4;     // no births with this many others inside the radius
+constexpr int   FLOW_RADIUS        = 4;     // smoothing radius of the grass density behind the flow field
+constexpr float FLOW_TOLERANCE     = 0.05f; // relative change in a chunk's grass energy that triggers a refresh
+constexpr int   HERB_BLOCK         = 1024;  // herbivores per decision task
+constexpr int   CHUNK_SIZE         = 32;    // tiles per side of a chunk for chunked systems
+constexpr int   CHUNKS_X           = (WIDTH  + CHUNK_SIZE - 1) / CHUNK_SIZE;
+constexpr int   CHUNKS_Y           = (HEIGHT + CHUNK_SIZE - 1) / CHUNK_SIZE;
+constexpr int   BALANCE_RANGES_PER_THREAD = 4; // chunk ranges per thread, leaves slack for stealing
+constexpr float BALANCE_SMOOTHING  = 0.5f;  // weight of the newest cost sample per chunk
+constexpr int   STENCIL_BLOCK_ROWS = 16;    // rows per stencil task
+constexpr int   STENCIL_BLOCK_COLS = 1024;  // columns per cache block (3 rows stay in L1/L2)
+constexpr int   LITTER_BLOCK       = 4096;  // active litter tiles per task
+constexpr int   BIRTH_BLOCK        = 1024;  // deaths / births committed per task
+constexpr int   AGGREGATE_BLOCK    = 16;    // tiles per side of a cell in aggregates.csv
+constexpr int   DIST_HIST_BINS     = 32;    // histogram bins per gene_stats.csv row
+constexpr float DIST_ALPHA         = 0.005f; // relative error of the gene_stats.csv quantiles
+constexpr float DIST_MIN           = 1e-2f;  // smallest value the quantile sketch resolves
+constexpr int   DIST_BUCKETS       = 1200;   // sketch buckets, covers up to DIST_MIN * gamma^1198 (~1600)
+constexpr float CANOPY_SCALE       = 4096.0f; // canopy fixed-point steps per unit of energy
+constexpr int   DOMAIN_HALO        = std::max(LIGHT_RADIUS, FLOW_RADIUS + 1); // canopy rows mirrored from each neighbour domain
+constexpr size_t SHM_RING_BYTES    = 1 << 20; // shared-memory transport buffer per direction and rank pair
+constexpr int   ISLAND_MIGRATION_INTERVAL = 100; // ticks between migrations in an island run
+constexpr int   ISLAND_MIGRANTS    = 8;     // seeds each island sends per migration
+constexpr int   ISLAND_LANDING_TRIES = 32;  // random tiles a migrant seed tries before it is lost
+// a domain band is whole chunk rows, and the last one may hold only the map's tail rows
+static_assert(CHUNK_SIZE >= DOMAIN_HALO, "a domain band must cover its neighbours' halo");
+static_assert(HEIGHT % CHUNK_SIZE == 0 || HEIGHT % CHUNK_SIZE >= DOMAIN_HALO,
+              "the last domain band must cover its neighbour's halo");
 
-// occupancy grid
+// Fixed-point number with FRAC fractional bits stored in Rep. Sums and
+// differences are plain integer adds, so they are exact and independent of
+// order; products and quotients go through 64 bits. Converts from float
+// implicitly (rounding to nearest) and back to float only explicitly.
+template<int FRAC, class Rep>
+struct Fixed {
+    static constexpr Rep ONE = Rep(1) << FRAC;
+    Rep raw = 0;
+
+    constexpr Fixed() = default;
+    constexpr Fixed(float v) : raw(fromFloat(v)) {}
+    template<int F, class R> constexpr explicit Fixed(Fixed<F, R> o) : raw(fromFixed<F>(o.raw)) {}
+    static constexpr Fixed fromRaw(Rep r) { Fixed f; f.raw = r; return f; }
+    // Both conversions saturate when Rep is narrower than 64 bits instead of
+    // wrapping. fromFloat rounds to nearest; fromFixed truncates dropped bits.
+    template<int F, class R> static constexpr Rep fromFixed(R r) {
+        if constexpr(sizeof(Rep) < 8) {
+            constexpr int64_t lo = std::numeric_limits<Rep>::min(), hi = std::numeric_limits<Rep>::max();
+            if constexpr(F <= FRAC) {
+                constexpr int64_t scale = int64_t(1) << (FRAC - F);
+                return Rep(std::clamp(int64_t(r), lo / scale, hi / scale) * scale);
+            } else {
+                return Rep(std::clamp(int64_t(r) >> (F - FRAC), lo, hi));
+            }
+        } else {
+            if constexpr(F <= FRAC) return Rep(Rep(r) * (Rep(1) << (FRAC - F)));
+            else                    return Rep(r >> (F - FRAC));
+        }
+    }
+    static constexpr Rep fromFloat(float v) {
+        double s = double(v) * ONE + (v < 0.0f ? -0.5 : 0.5);
+        if constexpr(sizeof(Rep) < 8)
+            s = std::clamp(s, double(std::numeric_limits<Rep>::min()), double(std::numeric_limits<Rep>::max()));
+        return Rep(s);
+    }
+    constexpr explicit operator float() const { return float(raw) / ONE; }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) { return fromRaw(a.raw + b.raw); }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) { return fromRaw(a.raw - b.raw); }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) { return fromRaw(Rep((int64_t(a.raw) * b.raw) >> FRAC)); }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) { return fromRaw(Rep((int64_t(a.raw) << FRAC) / b.raw)); }
+    Fixed &operator+=(Fixed b) { raw += b.raw; return *this; }
+    Fixed &operator-=(Fixed b) { raw -= b.raw; return *this; }
+    Fixed &operator*=(Fixed b) { return *this = *this * b; }
+    friend constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend constexpr bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+    friend constexpr bool operator< (Fixed a, Fixed b) { return a.raw <  b.raw; }
+    friend constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend constexpr bool operator> (Fixed a, Fixed b) { return a.raw >  b.raw; }
+    friend constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+};
+
+// Numeric type of tile water, tile nutrients and plant energy. Building with
+// -DECOSIM_FIXED_POINT switches them to Q16.16 (range +-32768), which makes
+// the energy reductions exact and results independent of summation order
+// and floating-point flags.
+#ifdef ECOSIM_FIXED_POINT
+using Quantity  = Fixed<16, int32_t>;
+using EnergySum = Fixed<16, int64_t>; // per-chunk and map totals of plant energy
+#else
+using Quantity  = float;
+using EnergySum = float;
+#endif
+
+// 16-bit gene value in [-8, 8) with steps of 1/4096, read and written as float
+struct Gene16 {
+    int16_t q = 0;
+    Gene16() = default;
+    Gene16(float v) : q(int16_t(std::clamp(std::lround(v * 4096.0f), -32768L, 32767L))) {}
+    operator float() const { return q * (1.0f / 4096.0f); }
+};
+
+// Plant record layout. A plant is four components (Genes, Genome, Age,
+// Energy); its coordinates are its tile index in the occupancy grid. By
+// default each component is held in an entt pool that adds 8 bytes per plant
+// for its sparse and packed entity arrays, 68 bytes per plant.
+// -DECOSIM_COMPACT_PLANTS narrows the components (16-bit genes, birth tick
+// and maximum age, Q6.9 energy, 16-bit generation) and keeps them in
+// tile-indexed arrays instead of pools (see Plants below). Those take 18
+// bytes per tile on maps of up to 65536 tiles, 20 above, whether or not a
+// plant stands on it, so a plant costs 18 / occupancy bytes: about 26 at the
+// 70% of tiles the default map holds by tick 5000. Below 18 / 68 = 26%
+// occupancy (20 / 68 = 29% on larger maps) the default layout is smaller.
+// Both add the occupancy grid's 4 bytes per tile. Arithmetic still happens
+// in float / Quantity; only storage is narrowed.
+#ifdef ECOSIM_COMPACT_PLANTS
+using Coord       = uint16_t;
+using GeneValue   = Gene16;
+using TickStamp   = uint16_t;          // birth tick mod 2^16; plant ages stay far below that
+using PlantEnergy = Fixed<9, int16_t>; // +-64
+using Generation  = uint16_t;          // saturates
+using Lineage     = std::conditional_t<WIDTH * HEIGHT <= 65536, uint16_t, uint32_t>;
+static_assert(WIDTH <= 65536 && HEIGHT <= 65536, "compact plants use 16-bit coordinates");
+#else
+using Coord       = int;
+using GeneValue   = float;
+using TickStamp   = int;
+using PlantEnergy = Quantity;
+using Generation  = uint32_t;
+using Lineage     = uint32_t;
+#endif
+
+// occupancy grid: the plant standing on each tile, or entt::null
 typedef unsigned long long ull;
-static std::vector<bool> occupied( WIDTH*HEIGHT, false);
-inline bool isOccupied(int x, int y)   { return occupied[y * WIDTH + x]; }
-inline void setOccupied(int x, int y)  { occupied[y * WIDTH + x] = true; }
-inline void clearOccupied(int x, int y){ occupied[y * WIDTH + x] = false; }
+static std::vector<entt::entity> occupant( WIDTH*HEIGHT, entt::entity{entt::null});
+inline bool isOccupied(int x, int y)   { return occupant[y * WIDTH + x] != entt::null; }
+inline void setOccupied(int x, int y, entt::entity e) { occupant[y * WIDTH + x] = e; }
+// stands in for a plant on a halo tile owned by a neighbouring domain
+constexpr entt::entity HALO_PLANT{0xFFFFFFFEu};
 
-// Tile grid for abiotic components
-enum class TileType { Soil, Water };
-struct Tile { TileType type = TileType::Soil; float water = 10.0f; float nutrient = 5000.0f; };
-static std::vector<Tile> grid;
-inline Tile& at(int x, int y) { return grid[y * WIDTH + x]; }
+// Tile grid for abiotic components, stored as parallel arrays so the
+// environment kernels stream contiguous floats
+enum class TileType : uint8_t { Soil, Water };
+struct TileGrid {
+    std::vector<TileType> type;
+    std::vector<Quantity> water, nutrient;
+    std::vector<float>    litter, litterRate; // dead biomass and its mass-weighted decay rate
+};
+static TileGrid grid;
+static std::vector<Quantity> waterBack, nutrientBack; // stencil double buffers
+// tiles currently holding litter, listed per chunk so decomposition only
+// touches those and a chunk's deaths append without locking
+static std::vector<std::vector<int>> litterActive;
+static std::vector<uint8_t> litterListed;
+// energy standing on each tile and its (W+1)x(H+1) summed-area table, rebuilt
+// each tick so any shading radius costs four lookups per plant. Energy is
+// stored in fixed point (1/CANOPY_SCALE) so box sums are exact and do not
+// depend on which row the table starts from.
+static std::vector<int32_t> canopy;
+static std::vector<int64_t> canopySAT;
+// foraging flow field: unit gradient of smoothed grass energy per tile, and
+// the chunk energy it was last computed from
+static std::vector<float>  flowX, flowY;
+static std::vector<double> flowChunkEnergy;
+// fire: remaining burn ticks per tile, and the tiles currently burning
+static std::vector<uint8_t> fireTimer;
+static std::vector<int>     fireFront;
+inline int tileIndex(int x, int y) { return y * WIDTH + x; }
+inline int chunkOfTile(int ti) { return (ti / WIDTH / CHUNK_SIZE) * CHUNKS_X + (ti % WIDTH) / CHUNK_SIZE; }
+// tile rectangle [x0,x1) x [y0,y1) covered by a chunk
+struct ChunkRect { int x0, y0, x1, y1; };
+inline ChunkRect chunkRect(int c) {
+    int x0 = (c % CHUNKS_X) * CHUNK_SIZE, y0 = (c / CHUNKS_X) * CHUNK_SIZE;
+    return { x0, y0, std::min(x0 + CHUNK_SIZE, WIDTH), std::min(y0 + CHUNK_SIZE, HEIGHT) };
+}
+
+// Tile coordinates of a plant. Not a component: a plant is found through
+// the occupancy grid, whose tile index already gives them.
+struct Position { Coord x, y; };
+inline Position tilePosition(int ti) { return { Coord(ti % WIDTH), Coord(ti / WIDTH) }; }
 
 // Components
-struct Position { int x, y; };
-struct Genes    { float sunlightEff, waterEff, nutrientEff, decayRate; };
-struct Age      { int age = 0, maxAge = 100; };
-struct Energy   { float value = 0.0f; };
+struct Genes    { GeneValue sunlightEff, waterEff, nutrientEff; };  // hot: read by every plant update
+// Cold genetic data, read only on birth, death and output. Traits the tick
+// does not need go here so Genes stays small as the genome grows.
+struct Genome {
+    GeneValue  decayRate;
+    Generation generation; // 0 for seeded plants
+    Lineage    lineage;    // tile index of the seeded founder
+};
+struct Age      { TickStamp born = 0, maxAge = 100; }; // born: tick of the birth commit
+struct Energy   { PlantEnergy value = 0.0f; };
+
+// Genome traits. Each trait names its field in Genes (hot) or Genome (cold)
+// and says how it is seeded, mutated, clamped and named in the output; the
+// seeding, mutation and serialization code below is generated from
+// PlantTraits, in list order, so a new trait is a field plus one entry.
+// Seeding draws mean + gauss(rng) * seedSpread, a birth adds
+// gauss(MUTATION_STDDEV) * mutation. The efficiencies are only clamped to what
+// a Gene16 stores, [-8, 8), so the clamps never bind and selection can still
+// drive an efficiency below 0. gene_stats.csv bins [lo, hi) unless a trait
+// gives a narrower histLo/histHi for its spread (values outside fall into the
+// end bins).
+template<class C, GeneValue C::*M> struct TraitOf {
+    using Component = C;
+    static constexpr GeneValue C::*member = M;
+};
+struct SunlightEff : TraitOf<Genes, &Genes::sunlightEff> {
+    static constexpr const char *name = "sunEff";
+    static constexpr float seedMean = 1.0f, seedSpread = 1.0f, mutation = 1.0f, lo = -8.0f, hi = 8.0f;
+};
+struct WaterEff : TraitOf<Genes, &Genes::waterEff> {
+    static constexpr const char *name = "watEff";
+    static constexpr float seedMean = 1.0f, seedSpread = 1.0f, mutation = 1.0f, lo = -8.0f, hi = 8.0f;
+    // selected toward 0: half the plants sit below 0.25 by tick 5000 and the
+    // tails reach about -2.3 and 4.3, so [-8, 8) would leave most in one bin
+    static constexpr float histLo = -3.0f, histHi = 5.0f;
+};
+struct NutrientEff : TraitOf<Genes, &Genes::nutrientEff> {
+    static constexpr const char *name = "nutEff";
+    static constexpr float seedMean = 1.0f, seedSpread = 1.0f, mutation = 1.0f, lo = -8.0f, hi = 8.0f;
+};
+struct DecayRate : TraitOf<Genome, &Genome::decayRate> {
+    static constexpr const char *name = "decay";
+    static constexpr float seedMean = 0.5f, seedSpread = 0.1f, mutation = 0.02f, lo = 0.0f, hi = 1.0f;
+    // seeded with a standard deviation of seedSpread * MUTATION_STDDEV (0.005) and
+    // drifting slowly, so [0, 1) would put every plant into two bins
+    static constexpr float histLo = seedMean - 24 * seedSpread * MUTATION_STDDEV;
+    static constexpr float histHi = seedMean + 24 * seedSpread * MUTATION_STDDEV;
+};
+
+// histogram range of trait T: [histLo, histHi) if it has one, else [lo, hi)
+template<class T, class = void> struct HistRange {
+    static constexpr float lo = T::lo, hi = T::hi;
+};
+template<class T> struct HistRange<T, std::void_t<decltype(T::histLo)>> {
+    static constexpr float lo = T::histLo, hi = T::histHi;
+};
+
+template<class... T> struct TraitList {
+    static constexpr size_t size = sizeof...(T);
+    template<class F> static void each(F &&f) { (f(T{}), ...); }
+};
+using PlantTraits = TraitList<SunlightEff, WaterEff, NutrientEff, DecayRate>;
+
+template<class T> GeneValue &trait(Genes &g, Genome &gm) {
+    if constexpr(std::is_same_v<typename T::Component, Genes>) return g.*T::member;
+    else                                                       return gm.*T::member;
+}
+template<class Gauss> void seedTraits(Genes &g, Genome &gm, Gauss &&gauss) {
+    PlantTraits::each([&](auto t){
+        using T = decltype(t);
+        trait<T>(g, gm) = std::clamp(T::seedMean + gauss() * T::seedSpread, T::lo, T::hi);
+    });
+}
+template<class Gauss> void mutateTraits(Genes &g, Genome &gm, Gauss &&gauss) {
+    PlantTraits::each([&](auto t){
+        using T = decltype(t);
+        GeneValue &v = trait<T>(g, gm);
+        v = std::clamp(float(v) + gauss() * T::mutation, T::lo, T::hi);
+    });
+}
+
+// age a plant reaches in its update at `tick`
+inline int ageAt(const Age &a, int tick) { return int(TickStamp(TickStamp(tick) - a.born)); }
 struct Dead     { bool dead = false; };
+struct Herbivore {
+    float x, y, heading, energy;
+    int age, maxAge;
+    uint64_t id; // stable across processes; keys the agent's random draws and its order among neighbours
+    int crowd;   // others within HERB_CROWD_RADIUS at the last decision
+};
+
+// Plant storage, addressed by tile through the occupancy grid. Default
+// builds keep the components in entt pools and reuse the entities of dead
+// plants, flagged Dead, through entityPool. Compact builds keep no entt state
+// per plant: the 12-byte hot record the plant update streams (Genes, Energy,
+// Age) and the cold Genome sit in two tile-indexed arrays, and the plant's id
+// in occupant is a serial number counted up per birth.
+#ifdef ECOSIM_COMPACT_PLANTS
+struct PlantRecord { Genes genes; Energy energy; Age age; };
+static_assert(sizeof(PlantRecord) == 12, "compact hot plant record");
+static_assert(sizeof(Genome) == sizeof(GeneValue) + sizeof(Generation) + sizeof(Lineage), "compact genome has padding");
+static std::vector<PlantRecord> plantRecords(WIDTH*HEIGHT);
+static std::vector<Genome>      plantGenomes(WIDTH*HEIGHT);
+static uint32_t nextPlantId = 0; // births so far
+
+class Plants {
+public:
+    explicit Plants(entt::registry &) {}
+    Genes  &genes(int ti)  const { return plantRecords[ti].genes; }
+    Genome &genome(int ti) const { return plantGenomes[ti]; }
+    Age    &age(int ti)    const { return plantRecords[ti].age; }
+    Energy &energy(int ti) const { return plantRecords[ti].energy; }
+    // writes the components of plant e and puts it on tile ti
+    void place(int ti, entt::entity e, const Genes &g, const Genome &gm, Age age, Energy energy) const {
+        plantRecords[ti] = PlantRecord{g, energy, age};
+        plantGenomes[ti] = gm;
+        occupant[ti] = e;
+    }
+};
+
+// Appends the ids of n new plants to ids, in birth order. entt compares
+// ids with entt::null by their entity part only, so the serial number counts
+// through entity parts below the ones null and HALO_PLANT use and carries
+// into the version.
+inline void allocatePlants(entt::registry &, std::vector<entt::entity> &ids, size_t n) {
+    using traits = entt::entt_traits<entt::entity>;
+    constexpr uint32_t parts = traits::entity_mask - 1, versions = traits::version_mask;
+    for(size_t k=0; k<n; k++, nextPlantId++)
+        ids.push_back(traits::construct(nextPlantId % parts, traits::version_type(nextPlantId / parts % versions)));
+}
+// releases the ids of plants already taken off the occupancy grid
+template<class It> void freePlants(entt::registry &, It, It) {}
+#else
+static std::vector<entt::entity> entityPool; // entities of dead plants, reused by births
+
+class Plants {
+public:
+    explicit Plants(entt::registry &reg) : view(reg.view<Genes, Genome, Age, Energy>()) {}
+    Genes  &genes(int ti)  const { return view.get<Genes>(occupant[ti]); }
+    Genome &genome(int ti) const { return view.get<Genome>(occupant[ti]); }
+    Age    &age(int ti)    const { return view.get<Age>(occupant[ti]); }
+    Energy &energy(int ti) const { return view.get<Energy>(occupant[ti]); }
+    // writes the components of plant e and puts it on tile ti
+    void place(int ti, entt::entity e, const Genes &g, const Genome &gm, Age age, Energy energy) const {
+        auto [pg, pgm, pa, pe] = view.get<Genes, Genome, Age, Energy>(e);
+        pg = g; pgm = gm; pa = age; pe = energy;
+        occupant[ti] = e;
+    }
+
+private:
+    decltype(std::declval<entt::registry &>().view<Genes, Genome, Age, Energy>()) view;
+};
+
+// Appends the entities of n new plants to ids, in birth order: pooled ones
+// first, then new ones, with the structural registry changes in batches.
+inline void allocatePlants(entt::registry &reg, std::vector<entt::entity> &ids, size_t n) {
+    size_t first = ids.size(), reuse = std::min(n, entityPool.size());
+    ids.insert(ids.end(), entityPool.rbegin(), entityPool.rbegin() + reuse);
+    entityPool.resize(entityPool.size() - reuse);
+    reg.remove<Dead>(ids.begin() + first, ids.end());
+    ids.resize(first + n);
+    auto fresh = ids.begin() + first + reuse;
+    reg.create(fresh, ids.end());
+    reg.insert<Genes>(fresh, ids.end());
+    reg.insert<Genome>(fresh, ids.end());
+    reg.insert<Age>(fresh, ids.end());
+    reg.insert<Energy>(fresh, ids.end());
+}
+// marks plants already taken off the occupancy grid dead and pools their entities
+template<class It> void freePlants(entt::registry &reg, It first, It last) {
+    reg.insert<Dead>(first, last, Dead{true});
+    entityPool.insert(entityPool.end(), first, last);
+}
+#endif
+
+// Schemas. Schema<C>::fields lists the fields of a component or output row
+// as (name, member) pairs; a member whose type has a schema of its own is
+// flattened into its fields. The CSV writers, the binary plant output and
+// the checkpoints are generated from these lists, and binary files carry
+// them in their header so readers find fields by name.
+template<class C, class M> struct Field { const char *name; M C::*member; };
+template<class C, class M> constexpr Field<C, M> field(const char *name, M C::*member) { return {name, member}; }
+template<class C> struct Schema;
+
+template<class T, class = void> struct HasSchema : std::false_type {};
+template<class T> struct HasSchema<T, std::void_t<decltype(Schema<T>::fields)>> : std::true_type {};
+
+// calls f(name, value) for every leaf field of obj, in schema order
+template<class C, class F> void forEachField(C &obj, F &&f) {
+    std::apply([&](auto... fd){
+        ([&]{
+            auto &v = obj.*fd.member;
+            if constexpr(HasSchema<std::remove_cv_t<std::remove_reference_t<decltype(v)>>>::value) forEachField(v, f);
+            else f(fd.name, v);
+        }(), ...);
+    }, Schema<std::remove_cv_t<C>>::fields);
+}
+
+// How a leaf field is printed in CSV and described in binary headers:
+// <i|u|f><bytes>, plus .<fraction bits> for fixed point.
+template<class T> struct FieldType {
+    static std::string tag() {
+        return (std::is_floating_point_v<T> ? "f" : std::is_signed_v<T> ? "i" : "u") + std::to_string(sizeof(T));
+    }
+    static auto text(T v) { return +v; }
+};
+template<int F, class R> struct FieldType<Fixed<F, R>> {
+    static std::string tag() { return FieldType<R>::tag() + "." + std::to_string(F); }
+    static float text(Fixed<F, R> v) { return float(v); }
+};
+template<> struct FieldType<Gene16> {
+    static std::string tag() { return "i2.12"; }
+    static float text(Gene16 v) { return float(v); }
+};
+
+// trait fields of component C, generated from PlantTraits
+template<class C, class T> constexpr auto traitField() {
+    if constexpr(std::is_same_v<typename T::Component, C>) return std::make_tuple(field(T::name, T::member));
+    else return std::tuple<>{};
+}
+template<class C, class... T> constexpr auto traitFields(TraitList<T...>) { return std::tuple_cat(traitField<C, T>()...); }
+
+template<> struct Schema<Position> {
+    static constexpr auto fields = std::make_tuple(field("x", &Position::x), field("y", &Position::y));
+};
+template<> struct Schema<Age> {
+    static constexpr auto fields = std::make_tuple(field("born", &Age::born), field("maxAge", &Age::maxAge));
+};
+template<> struct Schema<Energy> {
+    static constexpr auto fields = std::make_tuple(field("energy", &Energy::value));
+};
+template<> struct Schema<Genes> {
+    static constexpr auto fields = traitFields<Genes>(PlantTraits{});
+};
+template<> struct Schema<Genome> {
+    static constexpr auto fields = std::tuple_cat(traitFields<Genome>(PlantTraits{}),
+        std::make_tuple(field("lineage", &Genome::lineage), field("generation", &Genome::generation)));
+};
+template<> struct Schema<Herbivore> {
+    static constexpr auto fields = std::make_tuple(
+        field("x", &Herbivore::x), field("y", &Herbivore::y), field("heading", &Herbivore::heading),
+        field("energy", &Herbivore::energy), field("age", &Herbivore::age), field("maxAge", &Herbivore::maxAge),
+        field("id", &Herbivore::id), field("crowd", &Herbivore::crowd));
+};
+
+// Column selections are bit masks over a schema's leaf fields, in order.
+using Columns = uint64_t;
+constexpr Columns ALL_COLUMNS = ~Columns(0);
+
+template<class C> int fieldCount() {
+    C probe{}; int n = 0;
+    forEachField(probe, [&](const char *, auto &){ n++; });
+    return n;
+}
+// leaf index of a field name, or -1
+template<class C> int fieldIndex(const std::string &name) {
+    C probe{}; int k = 0, found = -1;
+    forEachField(probe, [&](const char *n, auto &){ if(found < 0 && name == n) found = k; k++; });
+    return found;
+}
+
+template<class C> void csvHeader(std::ostream &out, Columns columns = ALL_COLUMNS) {
+    C probe{};
+    const char *sep = ""; int k = 0;
+    forEachField(probe, [&](const char *name, auto &){
+        if(columns >> k++ & 1) { out << sep << name; sep = ","; }
+    });
+    out << '\n';
+}
+template<class C> void csvRow(std::ostream &out, const C &row, Columns columns = ALL_COLUMNS) {
+    const char *sep = ""; int k = 0;
+    forEachField(row, [&](const char *, auto &v){
+        if(columns >> k++ & 1) { out << sep << FieldType<std::decay_t<decltype(v)>>::text(v); sep = ","; }
+    });
+    out << '\n';
+}
+
+// Selected leaf fields of a schema, with their offset in C and in a packed
+// row that holds only them. With every column selected a packed row is C
+// itself. text prints a packed field as csvRow does.
+template<class C> struct RowLayout {
+    struct Leaf {
+        const char *name; size_t offset, packed, size; std::string tag;
+        void (*text)(std::ostream &, const char *);
+    };
+    std::vector<Leaf> leaves;
+    size_t rowBytes = 0;
+    bool whole = false;
+
+    explicit RowLayout(Columns columns = ALL_COLUMNS) {
+        C probe{}; int k = 0;
+        forEachField(probe, [&](const char *name, auto &v){
+            using T = std::decay_t<decltype(v)>;
+            if(columns >> k++ & 1)
+                leaves.push_back({name, size_t(reinterpret_cast<const char*>(&v) - reinterpret_cast<const char*>(&probe)),
+                                  0, sizeof v, FieldType<T>::tag(),
+                                  [](std::ostream &out, const char *p){ T x; std::memcpy(&x, p, sizeof x); out << FieldType<T>::text(x); }});
+        });
+        whole = int(leaves.size()) == k;
+        for(auto &l : leaves) { l.packed = whole ? l.offset : rowBytes; rowBytes += l.size; }
+        if(whole) rowBytes = sizeof(C);
+    }
+
+    // appends the selected fields of row to buf
+    void pack(std::vector<char> &buf, const C &row) const {
+        size_t n = buf.size();
+        buf.resize(n + rowBytes);
+        char *p = buf.data() + n;
+        if(whole) { std::memcpy(p, &row, sizeof row); return; }
+        for(auto &l : leaves) { std::memcpy(p, reinterpret_cast<const char*>(&row) + l.offset, l.size); p += l.size; }
+    }
+    void csvRow(std::ostream &out, const char *row) const {
+        const char *sep = "";
+        for(auto &l : leaves) { out << sep; l.text(out, row + l.packed); sep = ","; }
+        out << '\n';
+    }
+};
+
+// Binary table: a text header naming each leaf field with its byte offset
+// and type, then the packed rows in one write.
+template<class C> void writeTable(std::ostream &out, const char *table, const RowLayout<C> &layout,
+                                  const char *rows, size_t count) {
+    out << "#table " << table << ' ' << count << ' ' << layout.rowBytes << '\n';
+    for(auto &l : layout.leaves) out << "#field " << l.name << ' ' << l.packed << ' ' << l.tag << '\n';
+    out << "#data\n";
+    out.write(rows, std::streamsize(count * layout.rowBytes));
+}
+template<class C> void writeTable(std::ostream &out, const char *table, const std::vector<C> &rows) {
+    static_assert(std::is_trivially_copyable_v<C>, "binary tables are raw copies of their rows");
+    writeTable(out, table, RowLayout<C>(), reinterpret_cast<const char*>(rows.data()), rows.size());
+}
 
 // Counters
-static ull energyDeaths = 0, waterDeaths = 0, oldAgeDeaths = 0, grassAlive = 0;
+static ull energyDeaths = 0, waterDeaths = 0, oldAgeDeaths = 0, fireDeaths = 0, grassAlive = 0;
+static ull herbivoresAlive = 0;
 static float avgGrassEnergy = 0.0f;
 
 // Random
@@ -50,20 +592,546 @@ std::mt19937_64 rng{12345};
 std::normal_distribution<float> gauss(0.0f, MUTATION_STDDEV);
 std::uniform_real_distribution<>  uni(0.0f,1.0f);
 
-// Pool for dead entities
-static std::vector<entt::entity> entityPool;
+// Counter-based random numbers: a pure function of the inputs, so parallel
+// kernels draw the same values however the work is scheduled
+inline uint64_t mix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+inline float hashUniform(uint64_t a, uint64_t b) {
+    return float(mix64(mix64(a) ^ b) >> 40) * (1.0f / 16777216.0f);
+}
+// stream of such numbers for one (a, b) pair, e.g. (tick, tile)
+struct HashRng {
+    uint64_t state;
+    HashRng(uint64_t a, uint64_t b) : state(mix64(mix64(a) ^ b)) {}
+    uint64_t next() { return mix64(state++); }
+    float uniform() { return float(next() >> 40) * (1.0f / 16777216.0f); }
+    float gauss(float stddev) {
+        float u1 = (float(next() >> 40) + 0.5f) * (1.0f / 16777216.0f);
+        return stddev * std::sqrt(-2.0f * std::log(u1)) * std::cos(2*PI*uniform());
+    }
+};
+
+// Tile claims: every agent that wants a tile this tick posts a key and the
+// lowest key wins. Keys carry a hash of (tick, claimant) in the high bits and
+// the claimant id in the low bits, so they never tie and the winner does not
+// depend on proposal order or thread timing.
+constexpr uint64_t NO_CLAIM = ~0ull;
+static std::vector<std::atomic<uint64_t>> tileClaims(WIDTH*HEIGHT);
+inline uint64_t claimKey(int tick, uint32_t claimant) {
+    return (mix64((uint64_t(tick) << 32) | claimant) & 0xFFFFFFFF00000000ull) | claimant;
+}
+inline void claimTile(int ti, uint64_t key) {
+    uint64_t cur = tileClaims[ti].load(std::memory_order_relaxed);
+    while(key < cur && !tileClaims[ti].compare_exchange_weak(cur, key, std::memory_order_relaxed)) {}
+}
+inline bool wonClaim(int ti, uint64_t key) { return tileClaims[ti].load(std::memory_order_relaxed) == key; }
+inline void releaseClaim(int ti) { tileClaims[ti].store(NO_CLAIM, std::memory_order_relaxed); }
+
+// Storm cells: Gaussian rain footprints drifting across the map
+struct Storm { float x, y, vx, vy, sigma, intensity; int ticksLeft; };
+static std::vector<Storm> storms;
+std::mt19937_64 weatherRng{777};
+
+// Work-stealing job system. Every thread (pool workers plus the thread that
+// created the system, slot 0) owns a deque: it pushes and pops jobs at the
+// back and idle threads steal from the front of others, so chunk tasks of
+// very uneven cost still spread over all cores. wait() runs jobs while it
+// waits, which makes nested parallelFor calls safe. Workers start in start()
+// rather than at construction, so a process can still fork into domain
+// processes before any thread exists.
+class JobSystem {
+public:
+    struct Counter { std::atomic<int> pending{0}; };
+
+    JobSystem() : queues(new Queue[1]), queueCount(1) {}
+
+    // call once, before any job is submitted
+    void start(unsigned n) {
+        queueCount = std::max(1u, n);
+        queues.reset(new Queue[queueCount]);
+        for(unsigned i=1; i<queueCount; i++) threads.emplace_back([this, i]{ workerLoop(i); });
+    }
+    ~JobSystem() {
+        { std::lock_guard<std::mutex> lk(sleepM); quit = true; }
+        sleepCv.notify_all();
+        for(auto &t : threads) t.join();
+    }
+
+    void submit(Counter &c, std::function<void()> fn) {
+        c.pending.fetch_add(1, std::memory_order_relaxed);
+        Queue &q = queues[self()];
+        { std::lock_guard<std::mutex> lk(q.m); q.jobs.push_back(Job{std::move(fn), &c}); }
+        queued.fetch_add(1, std::memory_order_release);
+        { std::lock_guard<std::mutex> lk(sleepM); }
+        sleepCv.notify_one();
+    }
+
+    void wait(Counter &c) {
+        while(c.pending.load(std::memory_order_acquire) > 0)
+            if(!runOne()) std::this_thread::yield();
+    }
+
+    // Splits [begin,end) into grain-sized jobs; fn(lo,hi) runs once per block.
+    void parallelFor(int begin, int end, int grain, const std::function<void(int,int)> &fn) {
+        if(end <= begin) return;
+        if(queueCount == 1 || end - begin <= grain) { fn(begin, end); return; }
+        Counter c;
+        for(int lo=begin; lo<end; lo+=grain) {
+            int hi = std::min(lo + grain, end);
+            submit(c, [&fn, lo, hi]{ fn(lo, hi); });
+        }
+        wait(c);
+    }
+
+    unsigned size() const { return queueCount; }
+    // slot of the calling thread in [0, size()), for per-thread accumulators
+    unsigned worker() const { return self(); }
+
+private:
+    struct Job   { std::function<void()> fn; Counter *counter; };
+    struct Queue { std::mutex m; std::deque<Job> jobs; };
+
+    static thread_local unsigned slot;
+    unsigned self() const { return slot < queueCount ? slot : 0; }
+
+    bool runOne() {
+        unsigned me = self(), n = queueCount;
+        Job job;
+        bool found = false;
+        {
+            Queue &q = queues[me];
+            std::lock_guard<std::mutex> lk(q.m);
+            if(!q.jobs.empty()) { job = std::move(q.jobs.back()); q.jobs.pop_back(); found = true; }
+        }
+        for(unsigned k=1; k<n && !found; k++) {
+            Queue &q = queues[(me + k) % n];
+            std::lock_guard<std::mutex> lk(q.m);
+            if(!q.jobs.empty()) { job = std::move(q.jobs.front()); q.jobs.pop_front(); found = true; }
+        }
+        if(!found) return false;
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        job.fn();
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    void workerLoop(unsigned i) {
+        slot = i;
+        for(;;) {
+            if(runOne()) continue;
+            std::unique_lock<std::mutex> lk(sleepM);
+            sleepCv.wait(lk, [&]{ return quit || queued.load(std::memory_order_acquire) > 0; });
+            if(quit) return;
+        }
+    }
+
+    std::unique_ptr<Queue[]> queues;
+    unsigned queueCount;
+    std::vector<std::thread> threads;
+    std::mutex sleepM;
+    std::condition_variable sleepCv;
+    std::atomic<int> queued{0};
+    bool quit = false;
+};
+thread_local unsigned JobSystem::slot = 0;
+static JobSystem jobs;
+
+// Byte streams between the processes of a decomposed run, one per ordered
+// pair of ranks. Messages are length-prefixed on top of the stream.
+class Transport {
+public:
+    virtual ~Transport() = default;
+    virtual void bind(int rank) = 0; // called in each process after fork
+    virtual void track(int rank, long pid) { (void)rank; (void)pid; } // called by the parent after forking a rank
+    virtual void write(int peer, const void *data, size_t bytes) = 0;
+    virtual void read(int peer, void *data, size_t bytes) = 0;
+
+    void send(int peer, const std::vector<char> &msg) {
+        uint64_t n = msg.size();
+        write(peer, &n, sizeof n);
+        write(peer, msg.data(), msg.size());
+    }
+    void recv(int peer, std::vector<char> &msg) {
+        uint64_t n = 0;
+        read(peer, &n, sizeof n);
+        msg.resize(n);
+        read(peer, msg.data(), n);
+    }
+    // Both sides call this. The lower rank sends first, so two neighbours
+    // never both block on a full buffer whatever the message sizes.
+    void exchange(int self, int peer, const std::vector<char> &out, std::vector<char> &in) {
+        if(self < peer) { send(peer, out); recv(peer, in); }
+        else            { recv(peer, in);  send(peer, out); }
+    }
+};
+
+#if defined(__unix__)
+// One local stream socket per rank pair, created before fork.
+class SocketTransport : public Transport {
+public:
+    explicit SocketTransport(int ranks) : n(ranks), fds(ranks*ranks, -1) {
+        for(int a=0; a<n; a++) for(int b=a+1; b<n; b++) {
+            int sv[2];
+            if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) { std::perror("socketpair"); std::exit(1); }
+            fds[a*n + b] = sv[0];
+            fds[b*n + a] = sv[1];
+        }
+    }
+    ~SocketTransport() override { for(int fd : fds) if(fd >= 0) close(fd); }
+
+    void bind(int rank) override {
+        self = rank;
+        for(int k=0; k<n*n; k++)
+            if(k / n != rank && fds[k] >= 0) { close(fds[k]); fds[k] = -1; }
+    }
+    void write(int peer, const void *data, size_t bytes) override {
+        const char *p = static_cast<const char*>(data);
+        while(bytes > 0) {
+            ssize_t k = ::write(fds[self*n + peer], p, bytes);
+            if(k < 0) { std::perror("socket write"); std::exit(1); }
+            p += k; bytes -= size_t(k);
+        }
+    }
+    void read(int peer, void *data, size_t bytes) override {
+        char *p = static_cast<char*>(data);
+        while(bytes > 0) {
+            ssize_t k = ::read(fds[self*n + peer], p, bytes);
+            if(k <= 0) { std::perror("socket read"); std::exit(1); }
+            p += k; bytes -= size_t(k);
+        }
+    }
+
+private:
+    int n, self = -1;
+    std::vector<int> fds; // fds[a*n + b]: a's end of the a<->b socket
+};
+
+// Single-producer/single-consumer ring buffers in an anonymous shared
+// mapping made before fork, one per direction and rank pair. Messages larger
+// than a ring stream through it while the reader drains. The mapping also
+// holds the pid of each rank, so a process waiting on an empty or full ring
+// exits instead of spinning when the peer process is gone.
+class ShmTransport : public Transport {
+public:
+    explicit ShmTransport(int ranks)
+        : n(ranks), bytes(sizeof(Ring) * ranks * ranks + sizeof(std::atomic<uint64_t>) * ranks) {
+        void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(mem == MAP_FAILED) { std::perror("mmap"); std::exit(1); }
+        rings = static_cast<Ring*>(mem);
+        for(int k=0; k<n*n; k++) new (&rings[k]) Ring;
+        pids = reinterpret_cast<std::atomic<uint64_t>*>(rings + n*n);
+        for(int k=0; k<n; k++) new (&pids[k]) std::atomic<uint64_t>{0};
+    }
+    ~ShmTransport() override { munmap(rings, bytes); }
+
+    void bind(int rank) override { self = rank; pids[rank].store(uint64_t(getpid()), std::memory_order_relaxed); }
+    void track(int rank, long pid) override { pids[rank].store(uint64_t(pid), std::memory_order_relaxed); }
+    void write(int peer, const void *data, size_t len) override {
+        Ring &r = rings[self*n + peer];
+        const char *p = static_cast<const char*>(data);
+        uint64_t head = r.head.load(std::memory_order_relaxed);
+        while(len > 0) {
+            uint64_t room = SHM_RING_BYTES - (head - r.tail.load(std::memory_order_acquire));
+            if(room == 0) {
+                if(gone(peer)) { std::cerr << "shm write: rank " << peer << " has exited\n"; std::exit(1); }
+                std::this_thread::yield();
+                continue;
+            }
+            size_t k = std::min<uint64_t>({len, room, SHM_RING_BYTES - head % SHM_RING_BYTES});
+            std::memcpy(r.data + head % SHM_RING_BYTES, p, k);
+            head += k; p += k; len -= k;
+            r.head.store(head, std::memory_order_release);
+        }
+    }
+    void read(int peer, void *data, size_t len) override {
+        Ring &r = rings[peer*n + self];
+        char *p = static_cast<char*>(data);
+        uint64_t tail = r.tail.load(std::memory_order_relaxed);
+        while(len > 0) {
+            uint64_t avail = r.head.load(std::memory_order_acquire) - tail;
+            if(avail == 0) {
+                // the peer may have written its last bytes just before exiting
+                if(gone(peer) && r.head.load(std::memory_order_acquire) == tail) {
+                    std::cerr << "shm read: rank " << peer << " has exited\n";
+                    std::exit(1);
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            size_t k = std::min<uint64_t>({len, avail, SHM_RING_BYTES - tail % SHM_RING_BYTES});
+            std::memcpy(p, r.data + tail % SHM_RING_BYTES, k);
+            tail += k; p += k; len -= k;
+            r.tail.store(tail, std::memory_order_release);
+        }
+    }
+
+private:
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> head{0}; // bytes written, only the producer stores
+        alignas(64) std::atomic<uint64_t> tail{0}; // bytes read, only the consumer stores
+        char data[SHM_RING_BYTES];
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "rings are shared between processes");
+
+    // True once the process on rank peer has died. A dead child stays a
+    // zombie that kill() still finds until it is reaped, so the parent reaps
+    // it here; other processes see it once its own parent has.
+    bool gone(int peer) const {
+        pid_t pid = pid_t(pids[peer].load(std::memory_order_relaxed));
+        if(pid <= 0) return false; // not started yet
+        int status = 0;
+        if(waitpid(pid, &status, WNOHANG) == pid) return true;
+        return kill(pid, 0) != 0 && errno == ESRCH;
+    }
+
+    int n, self = -1;
+    size_t bytes;
+    Ring *rings;
+    std::atomic<uint64_t> *pids; // pid bound to each rank, 0 until known
+};
+#endif
+
+// Domain decomposition. A decomposed run splits the map into horizontal
+// bands of whole chunk rows, one process per band, plus a coordinator
+// process that merges the statistics. Each domain simulates only the tiles
+// and herbivores in its band and mirrors a halo of its neighbours' rows. A
+// single-process run is one domain covering the map with no transport.
+struct Domain {
+    int rank = 0, count = 1;            // domains are ranks 0..count-1, the coordinator is rank count
+    int y0 = 0, y1 = HEIGHT;            // owned tile rows
+    int c0 = 0, c1 = CHUNKS_X*CHUNKS_Y; // owned chunks, contiguous since bands are whole chunk rows
+    Transport *net = nullptr;
+
+    bool split() const { return count > 1; }
+    bool owns(int ti) const { return ti >= y0*WIDTH && ti < y1*WIDTH; }
+    int  up()    const { return rank > 0 ? rank - 1 : -1; }
+    int  down()  const { return rank + 1 < count ? rank + 1 : -1; }
+};
+static Domain domain;
+
+// Island model: several independent worlds on different terrain, one
+// process each, passing a few seeds round a ring every
+// ISLAND_MIGRATION_INTERVAL ticks over the lock-free shared-memory queues.
+struct Island {
+    int index = 0, count = 1;
+    Transport *net = nullptr;
+};
+static Island island;
+
+void assignDomain(int rank, int count, Transport *net) {
+    int r0 = CHUNKS_Y * rank / count, r1 = CHUNKS_Y * (rank + 1) / count;
+    domain.rank = rank; domain.count = count; domain.net = net;
+    domain.y0 = std::min(r0 * CHUNK_SIZE, HEIGHT); domain.y1 = std::min(r1 * CHUNK_SIZE, HEIGHT);
+    domain.c0 = r0 * CHUNKS_X;                     domain.c1 = r1 * CHUNKS_X;
+}
+
+// Swaps a vector of plain records with a neighbouring domain.
+template<class T>
+void exchangeItems(int peer, const std::vector<T> &out, std::vector<T> &in) {
+    static_assert(std::is_trivially_copyable<T>::value, "records are sent as raw bytes");
+    std::vector<char> sent(out.size() * sizeof(T)), got;
+    if(!out.empty()) std::memcpy(sent.data(), out.data(), sent.size());
+    domain.net->exchange(domain.rank, peer, sent, got);
+    in.resize(got.size() / sizeof(T));
+    if(!in.empty()) std::memcpy(in.data(), got.data(), got.size());
+}
+
+// Halo exchange: sends the first and last `rows` rows of the band to the
+// domains above and below and stores theirs just outside the band.
+template<class T>
+void exchangeRows(std::vector<T> &field, int rows) {
+    if(!domain.split()) return;
+    std::vector<T> out, in;
+    if(domain.up() >= 0) {
+        out.assign(field.begin() + domain.y0*WIDTH, field.begin() + std::min(domain.y0 + rows, domain.y1)*WIDTH);
+        exchangeItems(domain.up(), out, in);
+        std::copy(in.begin(), in.end(), field.begin() + domain.y0*WIDTH - in.size());
+    }
+    if(domain.down() >= 0) {
+        out.assign(field.begin() + std::max(domain.y1 - rows, domain.y0)*WIDTH, field.begin() + domain.y1*WIDTH);
+        exchangeItems(domain.down(), out, in);
+        std::copy(in.begin(), in.end(), field.begin() + domain.y1*WIDTH);
+    }
+}
+
+// Occupancy of the rows next to the band; entity ids do not carry across
+// processes, so neighbours' plants become HALO_PLANT markers.
+void exchangeOccupancy() {
+    if(!domain.split()) return;
+    exchangeRows(occupant, 1);
+    for(int y : {domain.y0 - 1, domain.y1}) {
+        if(y < 0 || y >= HEIGHT) continue;
+        for(int x=0; x<WIDTH; x++) {
+            entt::entity &o = occupant[tileIndex(x, y)];
+            if(o != entt::null) o = HALO_PLANT;
+        }
+    }
+}
+
+// Hilbert-curve index of (x,y) on an n x n grid, n a power of two
+inline uint32_t hilbertIndex(uint32_t n, uint32_t x, uint32_t y) {
+    uint32_t d = 0;
+    for(uint32_t s=n/2; s>0; s/=2) {
+        uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if(ry == 0) {
+            if(rx == 1) { x = n-1 - x; y = n-1 - y; }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Dynamic load balancing for per-chunk work. Chunks are ordered along a
+// Hilbert curve, so a contiguous run of them is a compact region. Each run()
+// times every chunk, and the next run cuts the curve into ranges of roughly
+// equal smoothed cost, BALANCE_RANGES_PER_THREAD per thread. Empty lake
+// chunks then cost almost nothing and dense ones get ranges of their own;
+// stealing absorbs what the estimate misses. Only the partition depends on
+// the timings, never the results. Covers the chunks of this process's domain.
+class ChunkBalancer {
+public:
+    ChunkBalancer() : cost(CHUNKS_X*CHUNKS_Y, 1.0f) {
+        uint32_t n = 1;
+        while(n < uint32_t(std::max(CHUNKS_X, CHUNKS_Y))) n *= 2;
+        for(int c=domain.c0; c<domain.c1; c++) order.push_back(c);
+        std::sort(order.begin(), order.end(), [n](int a, int b){
+            return hilbertIndex(n, a % CHUNKS_X, a / CHUNKS_X) < hilbertIndex(n, b % CHUNKS_X, b / CHUNKS_X);
+        });
+    }
+
+    void run(const std::function<void(int)> &fn) {
+        rebalance(jobs.size() * BALANCE_RANGES_PER_THREAD);
+        jobs.parallelFor(0, int(rangeStart.size()) - 1, 1, [&](int r0, int r1){
+            for(int k=rangeStart[r0]; k<rangeStart[r1]; k++) {
+                int c = order[k];
+                auto t0 = std::chrono::steady_clock::now();
+                fn(c);
+                float ns = std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - t0).count();
+                cost[c] += BALANCE_SMOOTHING * (ns - cost[c]);
+            }
+        });
+    }
+
+private:
+    void rebalance(unsigned parts) {
+        double total = 0.0;
+        for(float v : cost) total += v;
+        rangeStart.clear();
+        rangeStart.push_back(0);
+        double acc = 0.0, step = total / std::max(1u, parts);
+        for(int k=0; k<int(order.size()); k++) {
+            acc += cost[order[k]];
+            if(acc >= step * rangeStart.size() && k+1 < int(order.size())) rangeStart.push_back(k+1);
+        }
+        rangeStart.push_back(int(order.size()));
+    }
+
+    std::vector<int>   order;      // chunks in Hilbert order
+    std::vector<float> cost;       // smoothed nanoseconds per chunk
+    std::vector<int>   rangeStart; // range r covers order[rangeStart[r] .. rangeStart[r+1])
+};
+
+// Data a tick system touches, declared so the scheduler can find conflicts
+enum Resource : uint32_t {
+    RES_PLANTS     = 1u << 0,  // plant components, occupancy, entity pool, grassAlive
+    RES_HERBIVORES = 1u << 1,
+    RES_WATER      = 1u << 2,
+    RES_NUTRIENT   = 1u << 3,
+    RES_LITTER     = 1u << 4,
+    RES_CANOPY     = 1u << 5,  // canopy grid and its summed-area table
+    RES_FLOW       = 1u << 6,  // foraging flow field
+    RES_FIRE       = 1u << 7,
+    RES_WEATHER    = 1u << 8,  // storms and the weather RNG
+    RES_COMMIT     = 1u << 9,  // toKill / births buffers
+    RES_COUNTERS   = 1u << 10, // death counters and tick stats
+    RES_OUTPUT     = 1u << 11, // serializer caches and files
+    RES_COMM       = 1u << 12, // domain transport; keeps exchanges in the same order in every process
+};
+
+// Runs a tick's systems as a dependency graph. A system depends on every
+// earlier-declared system whose writes overlap its reads or writes, or whose
+// reads overlap its writes. Independent systems run concurrently as jobs and
+// conflicting ones keep declaration order, so results match a sequential run.
+class Scheduler {
+public:
+    struct System {
+        std::string name;
+        uint32_t reads, writes;
+        std::function<void(int)> run; // called with the tick
+    };
+
+    void add(System sys) { systems.push_back(std::move(sys)); built = false; }
+
+    void run(int tick) {
+        if(!built) build();
+        for(size_t i=0; i<systems.size(); i++) remaining[i].store(indegree[i], std::memory_order_relaxed);
+        JobSystem::Counter done;
+        std::function<void(int)> launch = [&](int i){
+            jobs.submit(done, [&, i]{
+                systems[i].run(tick);
+                for(int d : dependents[i])
+                    if(remaining[d].fetch_sub(1, std::memory_order_acq_rel) == 1) launch(d);
+            });
+        };
+        for(size_t i=0; i<systems.size(); i++) if(indegree[i] == 0) launch(int(i));
+        jobs.wait(done);
+    }
+
+private:
+    void build() {
+        size_t n = systems.size();
+        dependents.assign(n, {});
+        indegree.assign(n, 0);
+        remaining.reset(new std::atomic<int>[n]);
+        for(size_t j=0; j<n; j++) for(size_t i=0; i<j; i++) {
+            const System &a = systems[i], &b = systems[j];
+            if((a.writes & (b.reads | b.writes)) || (a.reads & b.writes)) {
+                dependents[i].push_back(int(j));
+                indegree[j]++;
+            }
+        }
+        built = true;
+    }
+
+    std::vector<System> systems;
+    std::vector<std::vector<int>> dependents;
+    std::vector<int> indegree;
+    std::unique_ptr<std::atomic<int>[]> remaining;
+    bool built = false;
+};
 
 void generateWorld(unsigned seed=12345) {
     std::mt19937_64 Wrng(seed);
-    grid.assign(WIDTH*HEIGHT, {});
+    grid.type.assign(WIDTH*HEIGHT, TileType::Soil);
+    grid.water.assign(WIDTH*HEIGHT, 10.0f);
+    grid.nutrient.assign(WIDTH*HEIGHT, 5000.0f);
+    grid.litter.assign(WIDTH*HEIGHT, 0.0f);
+    grid.litterRate.assign(WIDTH*HEIGHT, 0.0f);
+    waterBack.assign(WIDTH*HEIGHT, 0.0f);
+    nutrientBack.assign(WIDTH*HEIGHT, 0.0f);
+    litterActive.assign(CHUNKS_X*CHUNKS_Y, {});
+    litterListed.assign(WIDTH*HEIGHT, 0);
+    canopy.assign(WIDTH*HEIGHT, 0);
+    canopySAT.assign((WIDTH+1)*(HEIGHT+1), 0);
+    flowX.assign(WIDTH*HEIGHT, 0.0f);
+    flowY.assign(WIDTH*HEIGHT, 0.0f);
+    flowChunkEnergy.assign(CHUNKS_X*CHUNKS_Y, -1.0);
+    fireTimer.assign(WIDTH*HEIGHT, 0);
+    fireFront.clear();
+    for(auto &c : tileClaims) c.store(NO_CLAIM, std::memory_order_relaxed);
     int cx = WIDTH/2, cy = HEIGHT/2, r = std::min(WIDTH,HEIGHT)/6;
     for(int y=0;y<HEIGHT;y++) for(int x=0;x<WIDTH;x++) {
         int dx=x-cx, dy=y-cy;
         if(dx*dx+dy*dy <= r*r) {
-            auto &t = at(x,y);
-            t.type = TileType::Water;
-            t.water = 10.0f;
-            t.nutrient = 0.0f;
+            int i = tileIndex(x,y);
+            grid.type[i] = TileType::Water;
+            grid.water[i] = 10.0f;
+            grid.nutrient[i] = 0.0f;
         }
     }
     std::uniform_int_distribution<> edgeAng(0,359);
@@ -73,8 +1141,8 @@ void generateWorld(unsigned seed=12345) {
         for(int step=0; step<WIDTH; step++){
             int xi = std::clamp(int(x),0,WIDTH-1);
             int yi = std::clamp(int(y),0,HEIGHT-1);
-            at(xi,yi).type = TileType::Water;
-            at(xi,yi).water = 8.0f;
+            grid.type[tileIndex(xi,yi)] = TileType::Water;
+            grid.water[tileIndex(xi,yi)] = 8.0f;
             angle += (uni(Wrng)-0.5f)*0.4f;
             x += std::cos(angle);
             y += std::sin(angle);
@@ -82,116 +1150,572 @@ void generateWorld(unsigned seed=12345) {
     }
 }
 
+// mark the plant on tile ti dead, free the tile and release the plant for reuse
+void killPlant(entt::registry &reg, int ti) {
+    entt::entity e = occupant[ti];
+    occupant[ti] = entt::null;
+    freePlants(reg, &e, &e + 1);
+    grassAlive--;
+}
+
+// place a plant on a free tile, reusing a pooled entity if available
+entt::entity spawnPlant(entt::registry &reg, Position pos, const Genes &g, const Genome &gm, Age age, Energy energy) {
+    static std::vector<entt::entity> id;
+    id.clear();
+    allocatePlants(reg, id, 1);
+    Plants(reg).place(tileIndex(pos.x, pos.y), id[0], g, gm, age, energy);
+    grassAlive++;
+    return id[0];
+}
+
+// Every domain walks the whole map so the shared rng stays in step, and
+// keeps the plants in its own band.
 void seedGrass(entt::registry &reg) {
     for(int y=0;y<HEIGHT;y++) for(int x=0;x<WIDTH;x++){
-        if(at(x,y).type==TileType::Soil && !isOccupied(x,y) && uni(rng) < INITIAL_GRASS_PROB) {
-            auto e = reg.create();
-            reg.emplace<Position>(e, x, y);
-            Genes g{1.0f+gauss(rng), 1.0f+gauss(rng), 1.0f+gauss(rng), 0.5f+gauss(rng)*0.1f};
-            reg.emplace<Genes>(e, g);
+        if(grid.type[tileIndex(x,y)]==TileType::Soil && !isOccupied(x,y) && uni(rng) < INITIAL_GRASS_PROB) {
+            Genes g; Genome genome{};
+            seedTraits(g, genome, []{ return gauss(rng); });
+            genome.lineage = Lineage(tileIndex(x,y));
             int agePlus = int(gauss(rng)*10.0+0.5);
-            reg.emplace<Age>(e, Age{0, 50 + agePlus});
-            reg.emplace<Energy>(e, Energy{0.5f});
-
-            setOccupied(x,y);
-            grassAlive++;
+            if(!domain.owns(tileIndex(x,y))) continue;
+            spawnPlant(reg, Position{Coord(x),Coord(y)}, g, genome, Age{TickStamp(-1), TickStamp(50 + agePlus)}, Energy{0.5f});
         }
     }
 }
 
+void seedHerbivores(entt::registry &reg) {
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    int soil = int(std::count(grid.type.begin(), grid.type.end(), TileType::Soil));
+    uint64_t id = 0;
+    for(int n = int(soil * HERBIVORE_DENSITY); n > 0; ) {
+        float x = u(rng) * WIDTH, y = u(rng) * HEIGHT;
+        if(grid.type[tileIndex(int(x),int(y))] != TileType::Soil) continue;
+        Herbivore h{x, y, u(rng)*2*PI, HERB_REPRODUCE_ENERGY*0.5f,
+                    int(u(rng)*HERB_MAX_AGE*0.5f), HERB_MAX_AGE, id++, 0};
+        n--;
+        if(!domain.owns(tileIndex(int(x),int(y)))) continue;
+        reg.emplace<Herbivore>(reg.create(), h);
+        herbivoresAlive++;
+    }
+}
+
+// output rows of grass_states and simulation_stats
+struct PlantRow {
+    int tick, id;
+    Position pos;
+    int age, maxAge;
+    Energy energy;
+    Genes genes;
+    Genome genome;
+};
+template<> struct Schema<PlantRow> {
+    static constexpr auto fields = std::make_tuple(
+        field("tick", &PlantRow::tick), field("id", &PlantRow::id), field("pos", &PlantRow::pos),
+        field("age", &PlantRow::age), field("maxAge", &PlantRow::maxAge), field("energy", &PlantRow::energy),
+        field("genes", &PlantRow::genes), field("genome", &PlantRow::genome));
+};
+struct StatsRow {
+    int tick, totalEntities;
+    ull energyDeaths, waterDeaths, oldAgeDeaths;
+    float avgGrassEnergy;
+    ull fireDeaths, herbivores;
+};
+template<> struct Schema<StatsRow> {
+    static constexpr auto fields = std::make_tuple(
+        field("tick", &StatsRow::tick), field("totalEntities", &StatsRow::totalEntities),
+        field("energyDeaths", &StatsRow::energyDeaths), field("waterDeaths", &StatsRow::waterDeaths),
+        field("oldAgeDeaths", &StatsRow::oldAgeDeaths), field("avgGrassEnergy", &StatsRow::avgGrassEnergy),
+        field("fireDeaths", &StatsRow::fireDeaths), field("herbivores", &StatsRow::herbivores));
+};
+
+// What the plant output holds: the selected PlantRow columns of the plants
+// inside the region of interest (a rectangle, optionally narrowed by a
+// per-tile mask). Plants outside it are never captured. With sample > 0
+// only that many of them are written per tick: a fresh uniform sample each
+// tick, or with track a cohort followed until all its members have died,
+// after which a new cohort is drawn.
+struct OutputConfig {
+    Columns columns = ALL_COLUMNS;
+    int x0 = 0, y0 = 0, x1 = WIDTH, y1 = HEIGHT;
+    std::vector<uint8_t> mask; // WIDTH*HEIGHT, empty for the whole rectangle
+    int sample = 0;            // plants per tick, 0 for all
+    bool track = false;
+};
+static OutputConfig outputConfig;
+
+// Mask file: one text line per tile row, '1' or '#' selects a tile; short
+// lines and missing rows are unselected.
+bool loadRegionMask(const std::string &path, OutputConfig &cfg) {
+    std::ifstream in(path);
+    if(!in) return false;
+    cfg.mask.assign(size_t(WIDTH) * HEIGHT, 0);
+    std::string line;
+    for(int y=0; y<HEIGHT && std::getline(in, line); y++)
+        for(int x=0; x<WIDTH && x<int(line.size()); x++)
+            cfg.mask[tileIndex(x,y)] = line[x] == '1' || line[x] == '#';
+    return true;
+}
+
+// --columns tick,x,y,energy: names from the grass_states header
+bool parseColumns(const std::string &list, OutputConfig &cfg) {
+    cfg.columns = 0;
+    std::stringstream ss(list);
+    std::string name;
+    while(std::getline(ss, name, ',')) {
+        int k = fieldIndex<PlantRow>(name);
+        if(k < 0 || k >= 64) return false;
+        cfg.columns |= Columns(1) << k;
+    }
+    return cfg.columns != 0;
+}
+
+// --region x0,y0,x1,y1: tiles [x0,x1) x [y0,y1)
+bool parseRegion(const std::string &rect, OutputConfig &cfg) {
+    int x0, y0, x1, y1;
+    if(std::sscanf(rect.c_str(), "%d,%d,%d,%d", &x0, &y0, &x1, &y1) != 4) return false;
+    cfg.x0 = std::clamp(x0, 0, WIDTH); cfg.x1 = std::clamp(x1, cfg.x0, WIDTH);
+    cfg.y0 = std::clamp(y0, 0, HEIGHT); cfg.y1 = std::clamp(y1, cfg.y0, HEIGHT);
+    return true;
+}
+
+// Sampling draws the plants with the smallest keys, a hash of (tick, tile):
+// a uniform sample without replacement that the chunks can take in parallel
+// (each keeps its own smallest) and that does not depend on thread count.
+// Under --domains each domain draws its own K from its band, so the output
+// holds K rows per domain rather than a uniform sample of the whole map.
+inline uint64_t sampleKey(int tick, int ti) {
+    return mix64(((uint64_t(tick) << 32) | uint32_t(ti)) ^ 0x53414D504C45ull);
+}
+struct SamplePick { uint64_t key; int ti; };
+inline void keepSmallest(std::vector<SamplePick> &picks, size_t k) {
+    if(picks.size() <= k) return;
+    std::nth_element(picks.begin(), picks.begin() + k, picks.end(),
+                     [](const SamplePick &a, const SamplePick &b){ return a.key < b.key; });
+    picks.resize(k);
+}
+
 struct Serializer {
-    std::vector<std::tuple<
-        int, /* tick */
-        int, /* id */
-        int, /* x */
-        int, /* y */
-        int, /* age */
-        int, /* maxAge */
-        float, /* energy */
-        float, /* sunEff */
-        float, /* watEff */
-        float, /* nutEff */
-        float  /* decayRate */
-    >> vegCache;
-
-    std::vector<std::tuple<
-        int,    /* tick */
-        int,    /* totalEntities */
-        unsigned long long, /* energyDeaths */
-        unsigned long long, /* waterDeaths */
-        unsigned long long, /* oldAgeDeaths */
-        float   /* avgGrassEnergy */
-    >> statsCache;
+    RowLayout<PlantRow> plantLayout{outputConfig.columns}; // captured columns
+    std::vector<char> vegCache;                   // packed plant rows
+    std::vector<std::vector<char>> chunkRows;     // per-chunk gather buffers
+    std::vector<std::vector<SamplePick>> chunkPicks; // per-chunk sample candidates
+    struct Sampled { int ti; entt::entity e; TickStamp born; };
+    std::vector<SamplePick> picks;
+    std::vector<Sampled> sampled;                 // this tick's sample, or the tracked cohort
+    std::vector<std::string> vegText;             // per-block formatted output
+    ChunkBalancer balance;                        // capture cost follows plant density
+    bool binary;                                  // plants as one binary table per flush
+
+    std::vector<StatsRow> statsCache;
     std::ofstream veg_out, world_out, stats_out;
 
-    Serializer() {
+    // Pipelining: saveTick only captures into vegCache/statsCache. A flush
+    // swaps them with the encode buffers and formats/writes those as a
+    // background job while the next ticks simulate. The two buffer pairs are
+    // reused, so capture does not allocate in steady state.
+    decltype(vegCache)   vegEncoding;
+    decltype(statsCache) statsEncoding;
+    JobSystem::Counter   encoding;
+
+    // A domain process writes only its plants (vegPath), the coordinator
+    // only the world and the merged stats (empty vegPath).
+    // grass_states.bin holds the same rows as the csv, each flush one table.
+    explicit Serializer(const std::string &vegPath = "grass_states.csv", bool writeStats = true, bool binary = false)
+        : binary(binary) {
         statsCache.reserve(SAVE_INTERVAL);
 
-        veg_out.open("grass_states.csv");
+        if(!vegPath.empty()) {
+            veg_out.open(vegPath, binary ? std::ios::binary : std::ios::out);
+            veg_out << "# WIDTH=" << WIDTH       << "\n"
+                    << "# HEIGHT=" << HEIGHT     << "\n"
+                    << "# MAX_TICKS=" << MAX_TICKS << "\n"
+                    << "# SAVE_INTERVAL=" << SAVE_INTERVAL << "\n";
+            if(!binary) csvHeader<PlantRow>(veg_out, outputConfig.columns);
+        }
+        if(!writeStats) return;
+
         stats_out.open("simulation_stats.csv");
-        veg_out << "# WIDTH=" << WIDTH       << "\n"
-                << "# HEIGHT=" << HEIGHT     << "\n"
-                << "# MAX_TICKS=" << MAX_TICKS << "\n"
-                << "# SAVE_INTERVAL=" << SAVE_INTERVAL << "\n";
-        veg_out << "tick,id,x,y,age,maxAge,energy,sunEff,watEff,nutEff,decay\n";
-        
-        stats_out << "tick,totalEntities,energyDeaths,waterDeaths,oldAgeDeaths,avgGrassEnergy\n";
+        csvHeader<StatsRow>(stats_out);
 
         world_out.open("world_state.csv");
         world_out << "x,y,type\n";
         for(int y=0;y<HEIGHT;y++) for(int x=0;x<WIDTH;x++){
-            Tile &t = at(x,y);
             world_out << x << ',' << y << ','
-                      << (t.type==TileType::Soil ? "Soil" : "Water") << '\n';
+                      << (grid.type[tileIndex(x,y)]==TileType::Soil ? "Soil" : "Water") << '\n';
         }
     }
 
     void flushVegCache() {
-        // 1) write vegCache
-        for(auto &v : vegCache) {
-            auto [tk, id, x, y, age, maxAge,
-                energy, sunEff, watEff, nutEff, decayRate] = v;
-
-            veg_out
-            << tk << ',' << id  << ',' << x  << ',' << y
-            << ',' << age << ',' << maxAge << ',' << energy
-            << ',' << sunEff << ',' << watEff << ',' << nutEff
-            << ',' << decayRate << '\n';
-        }
-        vegCache.clear();
+        // 1) write vegEncoding: blocks are formatted in parallel, written in order
+        if(binary) {
+            if(!vegEncoding.empty())
+                writeTable(veg_out, "plants", plantLayout, vegEncoding.data(), vegEncoding.size() / plantLayout.rowBytes);
+            vegEncoding.clear();
+            return;
+        }
+        constexpr int BLOCK = 16384;
+        size_t rowBytes = plantLayout.rowBytes, rows = vegEncoding.size() / rowBytes;
+        int blocks = int((rows + BLOCK - 1) / BLOCK);
+        vegText.resize(blocks);
+        jobs.parallelFor(0, blocks, 1, [&](int b0, int b1){
+            for(int b=b0; b<b1; b++) {
+                std::ostringstream out;
+                size_t end = std::min(rows, size_t(b+1) * BLOCK);
+                for(size_t i=size_t(b) * BLOCK; i<end; i++) plantLayout.csvRow(out, vegEncoding.data() + i * rowBytes);
+                vegText[b] = out.str();
+            }
+        });
+        for(int b=0; b<blocks; b++) veg_out << vegText[b];
+        vegEncoding.clear();
        
     }
 
     void flushStatsCache() {
-         // 2) write statsCache
-        for(auto &s : statsCache) {
-            auto [tk, totalEnt, ed, wd, od, avg] = s;
-            stats_out
-            << tk        << ',' 
-            << totalEnt  << ',' 
-            << ed        << ','
-            << wd        << ','
-            << od        << ','
-            << avg       << '\n';
-            }
-            statsCache.clear();
+         // 2) write statsEncoding
+        for(auto &s : statsEncoding) csvRow(stats_out, s);
+        statsEncoding.clear();
     }
 
+    // Gathers live plants in the region of interest one job per chunk via
+    // the occupancy grid, then appends the chunk buffers in chunk order.
+    // When sampling, the chunks only propose their candidates and the rows
+    // of the K picked plants are built afterwards, in tile order.
     void saveTick(int tick, int totalEntities, entt::registry &reg) {
-        reg.view<Position,Age,Energy,Genes>().each(
-          [&](auto id, auto &pos, auto &age, auto &e, auto &g){
-            vegCache.emplace_back(tick, int(id), pos.x, pos.y, age.age, age.maxAge, e.value, g.sunlightEff, g.waterEff, g.nutrientEff, g.decayRate);
+        Plants plants(reg);
+        const OutputConfig &cfg = outputConfig;
+        size_t k = size_t(cfg.sample);
+        // a tracked cohort loses its dead, pooled or reused entities
+        sampled.erase(std::remove_if(sampled.begin(), sampled.end(), [&](const Sampled &s){
+            return occupant[s.ti] != s.e || plants.age(s.ti).born != s.born;
+        }), sampled.end());
+        bool pick = k && (!cfg.track || sampled.empty());
+        chunkRows.resize(CHUNKS_X*CHUNKS_Y);
+        chunkPicks.resize(CHUNKS_X*CHUNKS_Y);
+        if(!k || pick) balance.run([&](int c){
+            auto &rows = chunkRows[c];
+            auto &cand = chunkPicks[c];
+            rows.clear(); cand.clear();
+            ChunkRect r = chunkRect(c);
+            int x0 = std::max(r.x0, cfg.x0), x1 = std::min(r.x1, cfg.x1);
+            int y0 = std::max(r.y0, cfg.y0), y1 = std::min(r.y1, cfg.y1);
+            for(int y=y0; y<y1; y++) for(int x=x0; x<x1; x++) {
+                int ti = tileIndex(x,y);
+                entt::entity id = occupant[ti];
+                if(id == entt::null || (!cfg.mask.empty() && !cfg.mask[ti])) continue;
+                if(k) { cand.push_back(SamplePick{sampleKey(tick, ti), ti}); continue; }
+                const Age &age = plants.age(ti);
+                plantLayout.pack(rows, PlantRow{tick, int(id), tilePosition(ti), ageAt(age, tick), age.maxAge,
+                                                plants.energy(ti), plants.genes(ti), plants.genome(ti)});
+            }
+            keepSmallest(cand, k);
         });
-        statsCache.emplace_back(tick,totalEntities,energyDeaths,waterDeaths,oldAgeDeaths,avgGrassEnergy);
-        energyDeaths = waterDeaths = oldAgeDeaths = avgGrassEnergy = 0;
+        if(!k) {
+            for(auto &rows : chunkRows) vegCache.insert(vegCache.end(), rows.begin(), rows.end());
+        } else {
+            if(pick) {
+                picks.clear();
+                for(int c=domain.c0; c<domain.c1; c++) picks.insert(picks.end(), chunkPicks[c].begin(), chunkPicks[c].end());
+                keepSmallest(picks, k);
+                std::sort(picks.begin(), picks.end(), [](const SamplePick &a, const SamplePick &b){ return a.ti < b.ti; });
+                sampled.clear();
+                for(auto &p : picks) sampled.push_back(Sampled{p.ti, occupant[p.ti], plants.age(p.ti).born});
+            }
+            for(auto &s : sampled) {
+                const Age &age = plants.age(s.ti);
+                plantLayout.pack(vegCache, PlantRow{tick, int(s.e), tilePosition(s.ti), ageAt(age, tick), age.maxAge,
+                                                    plants.energy(s.ti), plants.genes(s.ti), plants.genome(s.ti)});
+            }
+        }
+        recordStats(tick,totalEntities,energyDeaths,waterDeaths,oldAgeDeaths,fireDeaths,avgGrassEnergy,herbivoresAlive);
+        energyDeaths = waterDeaths = oldAgeDeaths = fireDeaths = avgGrassEnergy = 0;
     }
 
+    void recordStats(int tick, int totalEntities, ull ed, ull wd, ull od, ull fd, float avg, ull herb) {
+        if(stats_out.is_open()) statsCache.push_back(StatsRow{tick,totalEntities,ed,wd,od,avg,fd,herb});
+    }
+
+    // Hands the captured ticks to the encoder. Waits only if the previous
+    // flush is still being written, which frees its buffers for reuse.
     void saveStatsCache() {
-        flushVegCache();
-        flushStatsCache();
+        jobs.wait(encoding);
+        vegCache.swap(vegEncoding);
+        statsCache.swap(statsEncoding);
+        jobs.submit(encoding, [this]{
+            flushVegCache();
+            flushStatsCache();
+        });
+    }
+
+    // final flush; returns once everything is on disk
+    void finish() {
+        saveStatsCache();
+        jobs.wait(encoding);
+        veg_out.flush();
+        stats_out.flush();
+    }
+};
+
+// Coarse maps for dashboards: every SAVE_INTERVAL ticks, one row per
+// AGGREGATE_BLOCK^2 cell with its plant count, the plants' mean energy and
+// genes, and the mean water and nutrient over all its tiles. Cell rows are
+// summed in parallel, each by one job in tile order.
+static_assert(CHUNK_SIZE % AGGREGATE_BLOCK == 0, "domain bands must hold whole aggregate cells");
+struct AggregateWriter {
+    static constexpr int CELLS_X = (WIDTH + AGGREGATE_BLOCK - 1) / AGGREGATE_BLOCK;
+    struct Cell { int plants; double energy, water, nutrient; std::array<double, PlantTraits::size> genes; };
+    std::vector<Cell> cells;
+    std::ofstream out;
+
+    explicit AggregateWriter(const std::string &path) : out(path) {
+        out << "# BLOCK=" << AGGREGATE_BLOCK << "\n" << "tick,bx,by,plants,energy";
+        PlantTraits::each([&](auto t){ out << ',' << t.name; });
+        out << ",water,nutrient\n";
+    }
+
+    void record(int tick, entt::registry &reg) {
+        Plants plants(reg);
+        int by0 = domain.y0 / AGGREGATE_BLOCK, by1 = (domain.y1 + AGGREGATE_BLOCK - 1) / AGGREGATE_BLOCK;
+        cells.assign(size_t(by1 - by0) * CELLS_X, Cell{});
+        jobs.parallelFor(by0, by1, 1, [&](int b0, int b1){
+            for(int by=b0; by<b1; by++) {
+                Cell *row = &cells[size_t(by - by0) * CELLS_X];
+                for(int y=by*AGGREGATE_BLOCK; y<std::min((by+1)*AGGREGATE_BLOCK, HEIGHT); y++)
+                    for(int x=0; x<WIDTH; x++) {
+                        int ti = tileIndex(x,y);
+                        Cell &c = row[x / AGGREGATE_BLOCK];
+                        c.water += float(grid.water[ti]); c.nutrient += float(grid.nutrient[ti]);
+                        if(occupant[ti] == entt::null) continue;
+                        Genes &g = plants.genes(ti); Genome &gm = plants.genome(ti);
+                        c.plants++; c.energy += float(plants.energy(ti).value);
+                        size_t k = 0;
+                        PlantTraits::each([&](auto t){ c.genes[k++] += trait<decltype(t)>(g, gm); });
+                    }
+            }
+        });
+        for(int by=by0; by<by1; by++) for(int bx=0; bx<CELLS_X; bx++) {
+            const Cell &c = cells[size_t(by - by0) * CELLS_X + bx];
+            int w = std::min(AGGREGATE_BLOCK, WIDTH - bx*AGGREGATE_BLOCK), h = std::min(AGGREGATE_BLOCK, HEIGHT - by*AGGREGATE_BLOCK);
+            double perPlant = c.plants ? 1.0 / c.plants : 0.0, perTile = 1.0 / (w * h);
+            out << tick << ',' << bx << ',' << by << ',' << c.plants << ',' << float(c.energy * perPlant);
+            for(double g : c.genes) out << ',' << float(g * perPlant);
+            out << ',' << float(c.water * perTile) << ',' << float(c.nutrient * perTile) << '\n';
+        }
+    }
+};
+
+// Streaming distribution of one per-plant quantity for gene_stats.csv: a
+// histogram over [lo, hi), with outliers in the end bins, and a DDSketch
+// quantile sketch whose log-spaced buckets give any quantile to within
+// DIST_ALPHA relative error. Negative values go to a mirrored set of buckets
+// below the zero bucket, which takes everything closer to 0 than DIST_MIN.
+// Both are plain counts, so per-thread copies merge by addition and the
+// result does not depend on which thread saw which plant.
+struct Distribution {
+    static constexpr int ZERO = DIST_BUCKETS - 1; // buckets[ZERO +- k] hold +-v
+    uint32_t count = 0;
+    uint32_t hist[DIST_HIST_BINS] = {};
+    uint32_t buckets[2 * DIST_BUCKETS - 1] = {};
+
+    static constexpr double GAMMA = (1.0 + DIST_ALPHA) / (1.0 - DIST_ALPHA);
+
+    // 0 for |v| < DIST_MIN (and NaN), else 1.. by log magnitude
+    static int magnitude(float v) {
+        if(!(v >= DIST_MIN)) return 0;
+        static const float invLogGamma = float(1.0 / std::log(GAMMA));
+        return 1 + std::min(DIST_BUCKETS - 2, int(std::ceil(std::log(v * (1.0f / DIST_MIN)) * invLogGamma)));
+    }
+    static int bucket(float v) { return v < 0.0f ? ZERO - magnitude(-v) : ZERO + magnitude(v); }
+    // midpoint (in relative terms) of the values bucket b holds
+    static double bucketValue(int b) {
+        int k = std::abs(b - ZERO);
+        double v = k ? 2.0 * DIST_MIN * std::pow(GAMMA, k - 1) / (1.0 + GAMMA) : 0.0;
+        return b < ZERO ? -v : v;
+    }
+
+    void add(float v, float lo, float hi) {
+        count++;
+        hist[int(std::clamp((v - lo) / (hi - lo) * DIST_HIST_BINS, 0.0f, DIST_HIST_BINS - 1.0f))]++;
+        buckets[bucket(v)]++;
+    }
+    Distribution &operator+=(const Distribution &o) {
+        count += o.count;
+        for(int i=0; i<DIST_HIST_BINS; i++) hist[i] += o.hist[i];
+        for(int i=0; i<2 * DIST_BUCKETS - 1; i++) buckets[i] += o.buckets[i];
+        return *this;
+    }
+    float quantile(float q) const {
+        if(!count) return 0.0f;
+        uint64_t rank = uint64_t(q * (count - 1)), seen = 0;
+        for(int b=0; b<2 * DIST_BUCKETS - 1; b++) if((seen += buckets[b]) > rank) return float(bucketValue(b));
+        return float(bucketValue(2 * DIST_BUCKETS - 2));
     }
 };
 
+// Energy, age and every PlantTraits gene of the live plants in one tick.
+struct PlantDistributions {
+    static constexpr float ENERGY_HI = 8.0f, AGE_HI = 128.0f; // histogram ranges start at 0
+    Distribution energy, age, genes[PlantTraits::size];
+
+    void add(float e, int years, Genes &g, Genome &gm) {
+        energy.add(e, 0.0f, ENERGY_HI);
+        age.add(float(years), 0.0f, AGE_HI);
+        size_t k = 0;
+        PlantTraits::each([&](auto t){
+            using T = decltype(t);
+            genes[k++].add(trait<T>(g, gm), HistRange<T>::lo, HistRange<T>::hi);
+        });
+    }
+    PlantDistributions &operator+=(const PlantDistributions &o) {
+        energy += o.energy; age += o.age;
+        for(size_t k=0; k<PlantTraits::size; k++) genes[k] += o.genes[k];
+        return *this;
+    }
+};
+
+// gene_stats.csv: per tick and quantity, the count, quantiles from the
+// sketch and the histogram bin counts.
+struct DistributionWriter {
+    std::ofstream out;
+
+    explicit DistributionWriter(const std::string &path) : out(path) {
+        out << "tick,quantity,count,lo,hi,p05,p25,p50,p75,p95";
+        for(int i=0; i<DIST_HIST_BINS; i++) out << ",h" << i;
+        out << '\n';
+    }
+
+    void row(int tick, const char *name, const Distribution &d, float lo, float hi) {
+        out << tick << ',' << name << ',' << d.count << ',' << lo << ',' << hi;
+        for(float q : {0.05f, 0.25f, 0.5f, 0.75f, 0.95f}) out << ',' << d.quantile(q);
+        for(uint32_t h : d.hist) out << ',' << h;
+        out << '\n';
+    }
+    void record(int tick, const PlantDistributions &d) {
+        row(tick, "energy", d.energy, 0.0f, PlantDistributions::ENERGY_HI);
+        row(tick, "age", d.age, 0.0f, PlantDistributions::AGE_HI);
+        size_t k = 0;
+        PlantTraits::each([&](auto t){
+            using T = decltype(t);
+            row(tick, T::name, d.genes[k++], HistRange<T>::lo, HistRange<T>::hi);
+        });
+    }
+};
+
+// Determinism check: with --hash FILE every tick appends one line of state
+// hashes, one per subsystem, so two runs can be compared tick by tick with
+// --compare. Plants are hashed in tile order and herbivores in id order,
+// never in registry order, so entity ids and storage layout do not count.
+inline uint64_t hashBytes(const void *data, size_t bytes, uint64_t h = 0) {
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    size_t k = 0;
+    for(; k + 8 <= bytes; k += 8) { uint64_t w; std::memcpy(&w, p + k, 8); h = mix64(h ^ w); }
+    uint64_t tail = 0;
+    if(k < bytes) std::memcpy(&tail, p + k, bytes - k);
+    return mix64(h ^ tail ^ bytes);
+}
+template<class T> inline uint64_t hashValue(uint64_t h, const T &v) { return hashBytes(&v, sizeof v, h); }
+
+// Hashes rows in parallel blocks; fn(y0, y1) returns the hash of a block.
+template<class F> uint64_t hashRows(F &&fn) {
+    int blocks = (HEIGHT + STENCIL_BLOCK_ROWS - 1) / STENCIL_BLOCK_ROWS;
+    std::vector<uint64_t> part(blocks);
+    jobs.parallelFor(0, blocks, 1, [&](int b0, int b1){
+        for(int b=b0; b<b1; b++) part[b] = fn(b * STENCIL_BLOCK_ROWS, std::min((b+1) * STENCIL_BLOCK_ROWS, HEIGHT));
+    });
+    return hashBytes(part.data(), part.size() * sizeof(uint64_t));
+}
+
+template<class T> uint64_t hashField(const std::vector<T> &f, uint64_t seed = 0) {
+    return hashRows([&](int y0, int y1){ return hashBytes(f.data() + y0*WIDTH, size_t(y1-y0) * WIDTH * sizeof(T), seed); });
+}
+
+// hashed as raw bytes, so padding would feed indeterminate bytes into the
+// hash; Genome is hashed field by field
+static_assert(sizeof(Genes) == 3 * sizeof(GeneValue), "Genes has padding");
+static_assert(sizeof(Age) == 2 * sizeof(TickStamp), "Age has padding");
+static_assert(sizeof(Storm) == 6 * sizeof(float) + sizeof(int), "Storm has padding");
+
+struct StateHasher {
+    std::ofstream out;
+
+    explicit StateHasher(const std::string &path) : out(path) {
+        out << "tick,water,nutrient,litter,fire,flow,plants,herbivores,weather,counters\n";
+    }
+
+    void record(int tick, entt::registry &reg) {
+        Plants plants(reg);
+        uint64_t plantHash = hashRows([&](int y0, int y1){
+            uint64_t h = 0;
+            for(int ti=y0*WIDTH; ti<y1*WIDTH; ti++) {
+                if(occupant[ti] == entt::null) continue;
+                const Genome &gm = plants.genome(ti);
+                h = hashValue(h, ti); h = hashValue(h, plants.genes(ti));
+                h = hashValue(h, gm.decayRate); h = hashValue(h, gm.lineage); h = hashValue(h, gm.generation);
+                h = hashValue(h, plants.age(ti)); h = hashValue(h, plants.energy(ti).value);
+            }
+            return h;
+        });
+        static std::vector<const Herbivore*> herd;
+        herd.clear();
+        reg.view<Herbivore>().each([](auto &h){ herd.push_back(&h); });
+        std::sort(herd.begin(), herd.end(), [](auto *a, auto *b){ return a->id < b->id; });
+        uint64_t herdHash = 0;
+        for(auto *h : herd) {
+            float f[4] = {h->x, h->y, h->heading, h->energy};
+            int i[3] = {h->age, h->maxAge, h->crowd};
+            herdHash = hashValue(hashValue(hashValue(herdHash, h->id), f), i);
+        }
+        std::mt19937_64 weatherNext = weatherRng;
+        uint64_t weatherHash = hashValue(hashBytes(storms.data(), storms.size() * sizeof(Storm)), weatherNext());
+        ull counters[6] = {grassAlive, herbivoresAlive, energyDeaths, waterDeaths, oldAgeDeaths, fireDeaths};
+        uint64_t counterHash = hashValue(hashValue(0, counters), avgGrassEnergy);
+
+        out << tick << std::hex
+            << ',' << hashField(grid.water)
+            << ',' << hashField(grid.nutrient)
+            << ',' << hashField(grid.litterRate, hashField(grid.litter))
+            << ',' << hashField(fireTimer)
+            << ',' << hashField(flowY, hashField(flowX))
+            << ',' << plantHash << ',' << herdHash << ',' << weatherHash << ',' << counterHash
+            << std::dec << '\n';
+    }
+};
+
+// --compare: reports the first tick at which two hash files differ and the
+// subsystems that differ there. Returns 0 when the files agree.
+int compareHashes(const std::string &pathA, const std::string &pathB) {
+    std::ifstream a(pathA), b(pathB);
+    if(!a || !b) { std::cerr << "cannot open " << (!a ? pathA : pathB) << "\n"; return 2; }
+    auto split = [](const std::string &line){
+        std::vector<std::string> cols;
+        std::stringstream ss(line);
+        for(std::string c; std::getline(ss, c, ',');) cols.push_back(c);
+        return cols;
+    };
+    std::string la, lb;
+    std::getline(a, la); std::getline(b, lb);
+    std::vector<std::string> names = split(la);
+    int ticks = 0;
+    for(;;) {
+        bool moreA = bool(std::getline(a, la)), moreB = bool(std::getline(b, lb));
+        if(!moreA && !moreB) break;
+        if(moreA != moreB) {
+            std::cout << (moreA ? pathB : pathA) << " ends after " << ticks << " ticks\n";
+            return 1;
+        }
+        if(la != lb) {
+            auto ca = split(la), cb = split(lb);
+            std::cout << "first divergence at tick " << ca[0] << ":";
+            for(size_t k=1; k<names.size(); k++)
+                if(k >= ca.size() || k >= cb.size() || ca[k] != cb[k]) std::cout << ' ' << names[k];
+            std::cout << "\n";
+            return 1;
+        }
+        ticks++;
+    }
+    std::cout << "identical over " << ticks << " ticks\n";
+    return 0;
+}
+
 float sunlight(int tick) {
     int seasonalTick = tick % SEASON_LENGTH;
     float dayLen = DAY_LENGTH * (1.0f + 0.2f * std::sin(2*PI*seasonalTick/SEASON_LENGTH));
@@ -199,134 +1723,1038 @@ float sunlight(int tick) {
     return std::clamp(1.0f - std::abs((tmod/dayLen)*2 - 1), 0.0f, 1.0f);
 }
 
-int main(){
+// Explicit 5-point diffusion over rows [y0,y1) of one tile field. Only soil
+// tiles change; with SoilOnly the exchange with water-tile neighbours is
+// masked out (no-flux), otherwise water tiles act as fixed-level sources. The
+// map edge is a no-flux border. Rows are processed in column blocks so the
+// three live rows stay cached, and the interior loop is branch-free over
+// contiguous arrays so the compiler can vectorize it.
+template<bool SoilOnly, class T>
+static void diffuseRows(const T *__restrict src, T *__restrict dst,
+                        const TileType *__restrict type, float rate, int y0, int y1) {
+    const T one = 1.0f, zero = 0.0f, k0 = rate;
+    auto w = [&](TileType t){ return (!SoilOnly || t==TileType::Soil) ? one : zero; };
+    for(int bx=0; bx<WIDTH; bx+=STENCIL_BLOCK_COLS) {
+        int bxEnd = std::min(bx + STENCIL_BLOCK_COLS, WIDTH);
+        for(int y=y0; y<y1; y++) {
+            const T *c = src + y*WIDTH;
+            const T *n = y > 0        ? c - WIDTH : c;
+            const T *s = y < HEIGHT-1 ? c + WIDTH : c;
+            const TileType *t  = type + y*WIDTH;
+            const TileType *tn = y > 0        ? t - WIDTH : t;
+            const TileType *ts = y < HEIGHT-1 ? t + WIDTH : t;
+            T *o = dst + y*WIDTH;
+            auto cell = [&](int x, int xl, int xr){
+                T k = t[x]==TileType::Soil ? k0 : zero;
+                o[x] = c[x] + k * (w(tn[x])*(n[x]-c[x]) + w(ts[x])*(s[x]-c[x])
+                                 + w(t[xl])*(c[xl]-c[x]) + w(t[xr])*(c[xr]-c[x]));
+            };
+            int x0 = std::max(bx, 1), x1 = std::min(bxEnd, WIDTH-1);
+            for(int x=x0; x<x1; x++) cell(x, x-1, x+1);
+            if(bx == 0)                     cell(0, 0, std::min(1, WIDTH-1));
+            if(bxEnd == WIDTH && WIDTH > 1) cell(WIDTH-1, WIDTH-2, WIDTH-1);
+        }
+    }
+}
+
+// Updates the domain's rows; the row on each side comes from the neighbours.
+template<bool SoilOnly, class T>
+static void diffuseField(std::vector<T> &field, std::vector<T> &back, float rate) {
+    exchangeRows(field, 1);
+    const T *src = field.data();
+    T *dst = back.data();
+    const TileType *type = grid.type.data();
+    jobs.parallelFor(domain.y0, domain.y1, STENCIL_BLOCK_ROWS, [&](int y0, int y1){
+        diffuseRows<SoilOnly>(src, dst, type, rate, y0, y1);
+    });
+    field.swap(back);
+}
+
+// Hydrology: soil water spreads between tiles and is fed by water tiles.
+void hydrologyStep() {
+    diffuseField<false>(grid.water, waterBack, HYDRO_DIFFUSION);
+}
+
+// Dead plants become litter on their tile; the tile's decay rate is the
+// mass-weighted mean of the decayRate genes that fed it.
+inline void depositLitter(int ti, float amount, float decayRate) {
+    float total = grid.litter[ti] + amount;
+    grid.litterRate[ti] = (grid.litterRate[ti]*grid.litter[ti] + std::clamp(decayRate, 0.0f, 1.0f)*amount) / total;
+    grid.litter[ti] = total;
+    if(!litterListed[ti]) {
+        litterListed[ti] = 1;
+        litterActive[chunkOfTile(ti)].push_back(ti);
+    }
+}
+
+// Decomposition releases a fraction of each active tile's litter into its
+// nutrient pool. Each tile appears once in its chunk's list, so chunks are
+// independent; exhausted tiles are dropped from the lists as they go.
+void decomposeLitter() {
+    constexpr int grain = std::max(1, LITTER_BLOCK / (CHUNK_SIZE*CHUNK_SIZE));
+    jobs.parallelFor(domain.c0, domain.c1, grain, [](int c0, int c1){
+        for(int c=c0; c<c1; c++) {
+            auto &tiles = litterActive[c];
+            for(int ti : tiles) {
+                float &l = grid.litter[ti];
+                float released = l * grid.litterRate[ti] * LITTER_DECAY_SCALE;
+                if(l - released < LITTER_EPSILON) released = l;
+                l -= released;
+                grid.nutrient[ti] += released;
+            }
+            tiles.erase(std::remove_if(tiles.begin(), tiles.end(), [](int ti){
+                if(grid.litter[ti] > 0.0f) return false;
+                litterListed[ti] = 0; grid.litterRate[ti] = 0.0f;
+                return true;
+            }), tiles.end());
+        }
+    });
+}
+
+// Nutrients spread between soil tiles only; water tiles neither give nor take.
+void nutrientStep(int tick) {
+    if(tick % NUTRIENT_DIFFUSION_INTERVAL == 0)
+        diffuseField<true>(grid.nutrient, nutrientBack, NUTRIENT_DIFFUSION * NUTRIENT_DIFFUSION_INTERVAL);
+}
+
+// Light competition: rasterize plant energy onto the canopy grid, then build
+// its summed-area table with a row-parallel prefix pass followed by a
+// column-strip-parallel pass (both walk contiguous memory). The table covers
+// the domain's band plus DOMAIN_HALO rows on each side, all that shading and
+// the flow field look at; exact sums make it agree with a whole-map table.
+void buildCanopy(entt::registry &reg) {
+    int lo = std::max(domain.y0 - DOMAIN_HALO, 0), hi = std::min(domain.y1 + DOMAIN_HALO, HEIGHT);
+    std::fill(canopy.begin() + lo*WIDTH, canopy.begin() + hi*WIDTH, 0);
+    Plants plants(reg);
+    jobs.parallelFor(domain.y0, domain.y1, STENCIL_BLOCK_ROWS, [&](int y0, int y1){
+        for(int ti=y0*WIDTH; ti<y1*WIDTH; ti++)
+            if(occupant[ti] != entt::null) canopy[ti] = int32_t(std::lround(float(plants.energy(ti).value) * CANOPY_SCALE));
+    });
+    exchangeRows(canopy, DOMAIN_HALO);
+    constexpr int SW = WIDTH + 1;
+    std::fill(canopySAT.begin() + lo*SW, canopySAT.begin() + (lo+1)*SW, 0);
+    jobs.parallelFor(lo, hi, STENCIL_BLOCK_ROWS, [](int y0, int y1){
+        for(int y=y0; y<y1; y++) {
+            const int32_t *c = canopy.data() + y*WIDTH;
+            int64_t *row = canopySAT.data() + (y+1)*SW + 1;
+            int64_t acc = 0;
+            for(int x=0; x<WIDTH; x++) { acc += c[x]; row[x] = acc; }
+        }
+    });
+    jobs.parallelFor(1, SW, STENCIL_BLOCK_COLS, [lo, hi](int x0, int x1){
+        for(int y=lo+2; y<=hi; y++) {
+            const int64_t *up = canopySAT.data() + (y-1)*SW;
+            int64_t *row = canopySAT.data() + y*SW;
+            for(int x=x0; x<x1; x++) row[x] += up[x];
+        }
+    });
+}
+
+// Canopy energy in the tile box [x0,x1) x [y0,y1), in canopy fixed point;
+// bounds must be on the map.
+inline int64_t canopyBox(int x0, int y0, int x1, int y1) {
+    constexpr int SW = WIDTH + 1;
+    const int64_t *s = canopySAT.data();
+    return s[y1*SW + x1] - s[y0*SW + x1] - s[y1*SW + x0] + s[y0*SW + x0];
+}
+
+// Mean canopy energy per tile within radius r of (x,y), clipped to the map.
+inline float canopyMean(int x, int y, int r) {
+    int x0 = std::max(x - r, 0), x1 = std::min(x + r, WIDTH-1) + 1;
+    int y0 = std::max(y - r, 0), y1 = std::min(y + r, HEIGHT-1) + 1;
+    return float(canopyBox(x0, y0, x1, y1)) / (CANOPY_SCALE * ((x1-x0)*(y1-y0)));
+}
+
+// Fraction of sunlight reaching a plant, reduced by the mean energy of the
+// other plants within LIGHT_RADIUS.
+inline float lightShare(int x, int y) {
+    int x0 = std::max(x - LIGHT_RADIUS, 0), x1 = std::min(x + LIGHT_RADIUS, WIDTH-1) + 1;
+    int y0 = std::max(y - LIGHT_RADIUS, 0), y1 = std::min(y + LIGHT_RADIUS, HEIGHT-1) + 1;
+    int64_t box = canopyBox(x0, y0, x1, y1) - canopy[tileIndex(x,y)];
+    int others = (x1-x0)*(y1-y0) - 1;
+    float neighbourMean = others > 0 ? float(box) / (CANOPY_SCALE * others) : 0.0f;
+    return 1.0f / (1.0f + LIGHT_COMPETITION * std::max(neighbourMean, 0.0f));
+}
+
+// Weather: spawn a Poisson number of storms per tick, drift and expire them.
+// Storms share a slowly turning prevailing wind plus a per-storm jitter.
+void updateStorms(int tick) {
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    std::poisson_distribution<int> spawns(STORM_SPAWN_RATE * WIDTH * HEIGHT);
+    float wind = 2*PI * float(tick % SEASON_LENGTH) / SEASON_LENGTH;
+    for(int n = spawns(weatherRng); n > 0; n--) {
+        float dir = wind + (u(weatherRng) - 0.5f);
+        storms.push_back(Storm{
+            u(weatherRng) * WIDTH, u(weatherRng) * HEIGHT,
+            STORM_SPEED * std::cos(dir), STORM_SPEED * std::sin(dir),
+            STORM_MIN_SIGMA + u(weatherRng) * (STORM_MAX_SIGMA - STORM_MIN_SIGMA),
+            STORM_INTENSITY * (0.5f + u(weatherRng)),
+            STORM_MIN_LIFE + int(u(weatherRng) * (STORM_MAX_LIFE - STORM_MIN_LIFE))});
+    }
+    for(auto &st : storms) { st.x += st.vx; st.y += st.vy; st.ticksLeft--; }
+    storms.erase(std::remove_if(storms.begin(), storms.end(), [](const Storm &st){
+        float reach = 3.0f * st.sigma;
+        return st.ticksLeft <= 0 || st.x < -reach || st.y < -reach
+            || st.x > WIDTH + reach || st.y > HEIGHT + reach;
+    }), storms.end());
+}
+
+// Rain: each storm adds its footprint to soil tiles within 3 sigma only.
+// Storms are binned to the chunks their footprint overlaps and every wet
+// chunk is one job applying its storms in order, so overlapping storms never
+// race. The Gaussian is separable: a row is one column profile times a row
+// weight, and the inner loop is a contiguous multiply-add. Every domain
+// tracks all storms and rains only on its own band.
+void applyStorms() {
+    static std::vector<std::vector<int>> chunkStorms(CHUNKS_X*CHUNKS_Y);
+    static std::vector<int> wet;
+    wet.clear();
+    for(int si=0; si<int(storms.size()); si++) {
+        const auto &st = storms[si];
+        float reach = 3.0f * st.sigma;
+        int x0 = std::max(int(st.x - reach), 0), x1 = std::min(int(st.x + reach) + 1, WIDTH);
+        int y0 = std::max(int(st.y - reach), domain.y0), y1 = std::min(int(st.y + reach) + 1, domain.y1);
+        if(x0 >= x1 || y0 >= y1) continue;
+        for(int cy=y0/CHUNK_SIZE; cy<=(y1-1)/CHUNK_SIZE; cy++)
+            for(int cx=x0/CHUNK_SIZE; cx<=(x1-1)/CHUNK_SIZE; cx++) {
+                auto &list = chunkStorms[cy*CHUNKS_X + cx];
+                if(list.empty()) wet.push_back(cy*CHUNKS_X + cx);
+                list.push_back(si);
+            }
+    }
+    jobs.parallelFor(0, int(wet.size()), 1, [](int lo, int hi){
+        float profile[CHUNK_SIZE];
+        for(int k=lo; k<hi; k++) {
+            int c = wet[k];
+            ChunkRect r = chunkRect(c);
+            for(int si : chunkStorms[c]) {
+                const auto &st = storms[si];
+                float reach = 3.0f * st.sigma, inv2s2 = 1.0f / (2.0f * st.sigma * st.sigma);
+                int x0 = std::max(int(st.x - reach), r.x0), x1 = std::min(int(st.x + reach) + 1, r.x1);
+                int y0 = std::max(int(st.y - reach), r.y0), y1 = std::min(int(st.y + reach) + 1, r.y1);
+                for(int x=x0; x<x1; x++) {
+                    float dx = x + 0.5f - st.x;
+                    profile[x-x0] = std::exp(-dx*dx*inv2s2);
+                }
+                for(int y=y0; y<y1; y++) {
+                    float dy = y + 0.5f - st.y;
+                    float amount = st.intensity * std::exp(-dy*dy*inv2s2);
+                    Quantity *__restrict w = grid.water.data() + y*WIDTH + x0;
+                    const TileType *__restrict t = grid.type.data() + y*WIDTH + x0;
+                    for(int x=0, n=x1-x0; x<n; x++) {
+                        float k = t[x]==TileType::Soil ? amount : 0.0f;
+                        w[x] += k * profile[x];
+                    }
+                }
+            }
+            chunkStorms[c].clear();
+        }
+    });
+}
+
+// Fire: a tile can burn while it carries a plant and is drier than
+// FIRE_DRY_WATER. Only the burning frontier and its neighbours are visited.
+// The frontier is grouped by chunk and each chunk proposes candidate tiles in
+// parallel; every candidate then decides independently from a hash of
+// (tick, tile) and its burning-neighbour count, so the outcome does not depend
+// on scheduling. Ignitions burn the plant through the normal death path.
+// A domain only ignites its own tiles; fire in the neighbours' edge rows
+// reaches it through the fireTimer halo.
+inline bool flammable(int ti) {
+    return domain.owns(ti) && fireTimer[ti] == 0 && occupant[ti] != entt::null && grid.water[ti] < FIRE_DRY_WATER;
+}
+
+void fireStep(int tick, entt::registry &reg) {
+    static std::vector<int> ignitions, candidates, groupStart;
+    static std::vector<std::vector<int>> groupCandidates;
+    static std::vector<uint8_t> ignite;
+    ignitions.clear(); candidates.clear(); groupStart.clear();
+    exchangeRows(fireTimer, 1);
+
+    // lightning: every domain draws every strike to keep weatherRng in step
+    std::uniform_int_distribution<int> anyTile(0, WIDTH*HEIGHT-1);
+    std::poisson_distribution<int> strikes(FIRE_LIGHTNING_RATE * WIDTH * HEIGHT);
+    for(int n = strikes(weatherRng); n > 0; n--) {
+        int ti = anyTile(weatherRng);
+        if(flammable(ti)) ignitions.push_back(ti);
+    }
+
+    // spread: group the frontier by chunk, gather unburnt fuel next to it
+    std::sort(fireFront.begin(), fireFront.end(), [](int a, int b){
+        int ca = chunkOfTile(a), cb = chunkOfTile(b);
+        return ca != cb ? ca < cb : a < b;
+    });
+    for(size_t i=0; i<fireFront.size(); i++)
+        if(i == 0 || chunkOfTile(fireFront[i]) != chunkOfTile(fireFront[i-1])) groupStart.push_back(int(i));
+    groupStart.push_back(int(fireFront.size()));
+    int groups = int(groupStart.size()) - 1;
+    if(int(groupCandidates.size()) < groups) groupCandidates.resize(groups);
+    jobs.parallelFor(0, groups, 1, [&](int g0, int g1){
+        for(int g=g0; g<g1; g++) {
+            auto &out = groupCandidates[g];
+            out.clear();
+            for(int i=groupStart[g]; i<groupStart[g+1]; i++) {
+                int ti = fireFront[i], x = ti % WIDTH, y = ti / WIDTH;
+                if(x > 0        && flammable(ti-1))     out.push_back(ti-1);
+                if(x < WIDTH-1  && flammable(ti+1))     out.push_back(ti+1);
+                if(y > 0        && flammable(ti-WIDTH)) out.push_back(ti-WIDTH);
+                if(y < HEIGHT-1 && flammable(ti+WIDTH)) out.push_back(ti+WIDTH);
+            }
+        }
+    });
+    for(int g=0; g<groups; g++)
+        candidates.insert(candidates.end(), groupCandidates[g].begin(), groupCandidates[g].end());
+    if(domain.split()) {
+        if(domain.y0 > 0)
+            for(int ti=(domain.y0-1)*WIDTH; ti<domain.y0*WIDTH; ti++)
+                if(fireTimer[ti] && flammable(ti+WIDTH)) candidates.push_back(ti+WIDTH);
+        if(domain.y1 < HEIGHT)
+            for(int ti=domain.y1*WIDTH; ti<(domain.y1+1)*WIDTH; ti++)
+                if(fireTimer[ti] && flammable(ti-WIDTH)) candidates.push_back(ti-WIDTH);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    ignite.assign(candidates.size(), 0);
+    jobs.parallelFor(0, int(candidates.size()), LITTER_BLOCK, [&](int lo, int hi){
+        for(int i=lo; i<hi; i++) {
+            int ti = candidates[i], x = ti % WIDTH, y = ti / WIDTH;
+            int burningNeighbours = (x > 0 && fireTimer[ti-1]) + (x < WIDTH-1 && fireTimer[ti+1])
+                                  + (y > 0 && fireTimer[ti-WIDTH]) + (y < HEIGHT-1 && fireTimer[ti+WIDTH]);
+            float p = FIRE_SPREAD_PROB * (1.0f - float(grid.water[ti]) / FIRE_DRY_WATER);
+            float pIgnite = 1.0f - std::pow(1.0f - p, float(burningNeighbours));
+            ignite[i] = hashUniform(uint64_t(tick), uint64_t(ti)) < pIgnite;
+        }
+    });
+    for(size_t i=0; i<candidates.size(); i++) if(ignite[i]) ignitions.push_back(candidates[i]);
+
+    // burn out the old frontier, then light the new tiles
+    fireFront.erase(std::remove_if(fireFront.begin(), fireFront.end(), [](int ti){
+        return --fireTimer[ti] == 0;
+    }), fireFront.end());
+    Plants plants(reg);
+    for(int ti : ignitions) {
+        if(fireTimer[ti]) continue; // struck and reached by spread in the same tick
+        fireTimer[ti] = FIRE_BURN_TICKS;
+        fireFront.push_back(ti);
+        fireDeaths++;
+        depositLitter(ti, std::max(float(plants.energy(ti).value), 1.0f), plants.genome(ti).decayRate);
+        killPlant(reg, ti);
+    }
+}
+
+// Foraging flow field: each tile stores the unit gradient of grass energy
+// smoothed over FLOW_RADIUS, read from the canopy summed-area table. A chunk
+// is only recomputed when the canopy energy its gradients depend on (the
+// chunk plus a FLOW_RADIUS+1 margin, itself a single table lookup) has moved
+// by more than FLOW_TOLERANCE since its last refresh.
+void updateFlowField() {
+    static std::vector<int> dirty;
+    dirty.clear();
+    constexpr int M = FLOW_RADIUS + 1;
+    for(int c=domain.c0; c<domain.c1; c++) {
+        int cx = (c % CHUNKS_X) * CHUNK_SIZE, cy = (c / CHUNKS_X) * CHUNK_SIZE;
+        double e = double(canopyBox(std::max(cx-M,0), std::max(cy-M,0),
+                                    std::min(cx+CHUNK_SIZE+M,WIDTH), std::min(cy+CHUNK_SIZE+M,HEIGHT))) / CANOPY_SCALE;
+        double last = flowChunkEnergy[c];
+        if(last < 0.0 || std::abs(e - last) > FLOW_TOLERANCE * (last + 1.0)) {
+            flowChunkEnergy[c] = e;
+            dirty.push_back(c);
+        }
+    }
+    jobs.parallelFor(0, int(dirty.size()), 1, [](int lo, int hi){
+        for(int k=lo; k<hi; k++) {
+            ChunkRect r = chunkRect(dirty[k]);
+            for(int y=r.y0; y<r.y1; y++) for(int x=r.x0; x<r.x1; x++) {
+                float gx = canopyMean(std::min(x+1,WIDTH-1), y, FLOW_RADIUS) - canopyMean(std::max(x-1,0), y, FLOW_RADIUS);
+                float gy = canopyMean(x, std::min(y+1,HEIGHT-1), FLOW_RADIUS) - canopyMean(x, std::max(y-1,0), FLOW_RADIUS);
+                float len = std::sqrt(gx*gx + gy*gy);
+                int ti = tileIndex(x,y);
+                flowX[ti] = len > 1e-6f ? gx / len : 0.0f;
+                flowY[ti] = len > 1e-6f ? gy / len : 0.0f;
+            }
+        }
+    });
+}
+
+// Uniform grid over agent positions, rebuilt each tick with a counting sort so
+// neighbour queries only touch the 3x3 cells around the query point.
+struct SpatialHash {
+    static constexpr float CELL = HERB_CROWD_RADIUS;
+    static constexpr int   CX = int((WIDTH  + CELL - 1) / CELL);
+    static constexpr int   CY = int((HEIGHT + CELL - 1) / CELL);
+    std::vector<int> cellStart; // CX*CY+1 offsets into items
+    std::vector<int> items;     // agent indices grouped by cell
+    std::vector<int> cellOfItem;
+
+    static int cellCoord(float v, int n) { return std::clamp(int(v / CELL), 0, n-1); }
+
+    void build(const std::vector<float> &xs, const std::vector<float> &ys) {
+        int n = int(xs.size());
+        cellStart.assign(CX*CY + 1, 0);
+        cellOfItem.resize(n);
+        items.resize(n);
+        for(int i=0; i<n; i++) {
+            cellOfItem[i] = cellCoord(ys[i], CY) * CX + cellCoord(xs[i], CX);
+            cellStart[cellOfItem[i] + 1]++;
+        }
+        for(int c=0; c<CX*CY; c++) cellStart[c+1] += cellStart[c];
+        std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+        for(int i=0; i<n; i++) items[fill[cellOfItem[i]]++] = i;
+    }
+
+    template<class F> void forEachNear(float x, float y, F &&f) const {
+        int cx = cellCoord(x, CX), cy = cellCoord(y, CY);
+        for(int gy=std::max(cy-1,0); gy<=std::min(cy+1,CY-1); gy++)
+            for(int gx=std::max(cx-1,0); gx<=std::min(cx+1,CX-1); gx++) {
+                int c = gy*CX + gx;
+                for(int k=cellStart[c]; k<cellStart[c+1]; k++) f(items[k]);
+            }
+    }
+};
+
+// Herbivores: every agent decides and takes its move in parallel from a
+// read-only snapshot of positions (food from the occupancy grid and flow
+// field, crowding from the spatial hash), then grazes, ages and breeds.
+// Agents are ordered by their stable id and plants shared by several grazers
+// are split evenly, so nothing depends on registry order. A domain sees the
+// agents within HERB_CROWD_RADIUS of its band as read-only ghosts, and hands
+// agents that walk out of its band to the neighbour before they graze.
+void herbivoreStep(int tick, entt::registry &reg) {
+    struct Slot { uint64_t id; float x, y; entt::entity e; }; // e is null for ghosts
+    static std::vector<Slot> slots;
+    static std::vector<Herbivore> toUp, toDown, in;
+    static std::vector<float> xs, ys;
+    static SpatialHash hash;
+    auto view = reg.view<Herbivore>();
+    slots.clear();
+    view.each([&](auto e, auto &h){ slots.push_back(Slot{h.id, h.x, h.y, e}); });
+    if(domain.split()) {
+        toUp.clear(); toDown.clear();
+        view.each([&](auto &h){
+            if(h.y <  domain.y0 + HERB_CROWD_RADIUS) toUp.push_back(h);
+            if(h.y >= domain.y1 - HERB_CROWD_RADIUS) toDown.push_back(h);
+        });
+        for(int peer : {domain.up(), domain.down()}) {
+            if(peer < 0) continue;
+            exchangeItems(peer, peer == domain.up() ? toUp : toDown, in);
+            for(auto &g : in) slots.push_back(Slot{g.id, g.x, g.y, entt::entity{entt::null}});
+        }
+    }
+    std::sort(slots.begin(), slots.end(), [](const Slot &a, const Slot &b){ return a.id < b.id; });
+    int n = int(slots.size());
+    xs.resize(n); ys.resize(n);
+    for(int i=0; i<n; i++) { xs[i] = slots[i].x; ys[i] = slots[i].y; }
+    hash.build(xs, ys);
+    updateFlowField();
+
+    jobs.parallelFor(0, n, HERB_BLOCK, [&](int lo, int hi){
+        for(int i=lo; i<hi; i++) {
+            if(slots[i].e == entt::null) continue;
+            auto &h = view.get<Herbivore>(slots[i].e);
+            int tx = int(h.x), ty = int(h.y);
+            float dx = 0.0f, dy = 0.0f;
+            if(!isOccupied(tx, ty)) {
+                // follow the flow field uphill, blended with a wander so
+                // herds do not all pile onto the same density peak
+                int ti = tileIndex(tx, ty);
+                float turn = (hashUniform(uint64_t(tick), h.id) - 0.5f) * 1.0f;
+                dx = flowX[ti] + std::cos(h.heading + turn);
+                dy = flowY[ti] + std::sin(h.heading + turn);
+            }
+            h.crowd = 0;
+            hash.forEachNear(h.x, h.y, [&](int j){
+                if(j == i) return;
+                float rx = h.x - xs[j], ry = h.y - ys[j], d2 = rx*rx + ry*ry;
+                if(d2 >= HERB_CROWD_RADIUS*HERB_CROWD_RADIUS) return;
+                h.crowd++;
+                if(d2 > 0.0f) { dx += rx / d2; dy += ry / d2; }
+            });
+            float len = std::sqrt(dx*dx + dy*dy);
+            float mx = len > 0.0f ? dx / len * HERB_SPEED : 0.0f, my = len > 0.0f ? dy / len * HERB_SPEED : 0.0f;
+            float nx = std::clamp(h.x + mx, 0.0f, WIDTH  - 0.001f);
+            float ny = std::clamp(h.y + my, 0.0f, HEIGHT - 0.001f);
+            if(grid.type[tileIndex(int(nx),int(ny))] == TileType::Soil) {
+                if(mx != 0.0f || my != 0.0f) h.heading = std::atan2(my, mx);
+                h.x = nx; h.y = ny;
+            } else {
+                h.heading += PI; // turn back at the shore
+            }
+        }
+    });
+
+    // agents that left the band continue in the neighbouring domain
+    if(domain.split()) {
+        static std::vector<entt::entity> left;
+        toUp.clear(); toDown.clear(); left.clear();
+        view.each([&](auto e, auto &h){
+            if(domain.owns(tileIndex(int(h.x), int(h.y)))) return;
+            (int(h.y) < domain.y0 ? toUp : toDown).push_back(h);
+            left.push_back(e);
+        });
+        for(auto e : left) reg.destroy(e);
+        herbivoresAlive -= left.size();
+        for(int peer : {domain.up(), domain.down()}) {
+            if(peer < 0) continue;
+            exchangeItems(peer, peer == domain.up() ? toUp : toDown, in);
+            for(auto &h : in) reg.emplace<Herbivore>(reg.create(), h);
+            herbivoresAlive += in.size();
+        }
+    }
+
+    // grazing: every agent on a plant asks for HERB_BITE, and when the plant
+    // cannot cover all of them they share what it has equally
+    static std::vector<uint16_t> grazers(WIDTH*HEIGHT, 0);
+    static std::vector<float> bite(WIDTH*HEIGHT, 0.0f);
+    static std::vector<int> grazed;
+    grazed.clear();
+    view.each([&](auto &h){
+        int ti = tileIndex(int(h.x), int(h.y));
+        if(occupant[ti] != entt::null && grazers[ti]++ == 0) grazed.push_back(ti);
+    });
+    Plants plants(reg);
+    for(int ti : grazed) {
+        Energy &plant = plants.energy(ti);
+        bite[ti] = std::min(HERB_BITE, std::max(float(plant.value), 0.0f) / grazers[ti]);
+        plant.value -= bite[ti] * grazers[ti];
+    }
+
+    static std::vector<entt::entity> dying;
+    static std::vector<Herbivore> born;
+    dying.clear(); born.clear();
+    view.each([&](auto e, auto &h){
+        int ti = tileIndex(int(h.x), int(h.y));
+        if(grazers[ti]) h.energy += bite[ti] * HERB_ASSIMILATION;
+        h.energy -= HERB_METABOLISM;
+        h.age++;
+        if(h.energy <= 0.0f || h.age >= h.maxAge) { dying.push_back(e); return; }
+        if(h.energy >= HERB_REPRODUCE_ENERGY && h.crowd < HERB_CROWD_MAX) {
+            h.energy *= 0.5f;
+            born.push_back(Herbivore{h.x, h.y, h.heading + PI, h.energy, 0, HERB_MAX_AGE,
+                                     mix64(h.id ^ mix64(uint64_t(tick))), 0});
+        }
+    });
+    for(int ti : grazed) grazers[ti] = 0;
+    for(auto e : dying) reg.destroy(e);
+    for(auto &b : born) reg.emplace<Herbivore>(reg.create(), b);
+    herbivoresAlive = herbivoresAlive + born.size() - dying.size();
+}
+
+// a seed waiting for the claim on its tile to be resolved
+struct Birth { uint64_t key; Position pos; Genes genes; Genome genome; Age age; Energy energy; };
+
+// Seeds aimed across the band edge are posted to the neighbouring domain and
+// claimed there next to its own; the keys are the ones a single process would
+// use, so the same seed wins.
+void routeBirths(std::vector<Birth> &births) {
+    static std::vector<Birth> toUp, toDown, in;
+    toUp.clear(); toDown.clear();
+    births.erase(std::remove_if(births.begin(), births.end(), [](const Birth &b){
+        int ti = tileIndex(b.pos.x, b.pos.y);
+        if(domain.owns(ti)) return false;
+        releaseClaim(ti);
+        (b.pos.y < domain.y0 ? toUp : toDown).push_back(b);
+        return true;
+    }), births.end());
+    for(int peer : {domain.up(), domain.down()}) {
+        if(peer < 0) continue;
+        exchangeItems(peer, peer == domain.up() ? toUp : toDown, in);
+        for(auto &b : in) {
+            claimTile(tileIndex(b.pos.x, b.pos.y), b.key);
+            births.push_back(b);
+        }
+    }
+}
+
+// Island migration: every island copies the genes of ISLAND_MIGRANTS plants
+// picked from (tick, island), sends them to the next island on the ring and
+// sows the seeds it receives on random free soil tiles. Each island sends
+// before it receives, and a handful of seeds always fits in the queue.
+struct Migrant { Genes genes; Genome genome; int maxAge; };
+
+void migrate(int tick, entt::registry &reg) {
+    if(island.count < 2 || tick == 0 || tick % ISLAND_MIGRATION_INTERVAL != 0) return;
+    static std::vector<int> planted;
+    static std::vector<Migrant> out, in;
+    planted.clear(); out.clear();
+    for(int ti=0; ti<WIDTH*HEIGHT; ti++) if(occupant[ti] != entt::null) planted.push_back(ti);
+    HashRng prng{uint64_t(tick), uint64_t(island.index)};
+    Plants plants(reg);
+    for(int k=0; k<ISLAND_MIGRANTS && !planted.empty(); k++) {
+        int ti = planted[size_t(prng.uniform() * planted.size())];
+        out.push_back(Migrant{plants.genes(ti), plants.genome(ti), plants.age(ti).maxAge});
+    }
+    std::vector<char> msg(out.size() * sizeof(Migrant));
+    if(!out.empty()) std::memcpy(msg.data(), out.data(), msg.size());
+    island.net->send((island.index + 1) % island.count, msg);
+    island.net->recv((island.index + island.count - 1) % island.count, msg);
+    in.resize(msg.size() / sizeof(Migrant));
+    if(!in.empty()) std::memcpy(in.data(), msg.data(), msg.size());
+    for(auto &m : in) {
+        for(int t=0; t<ISLAND_LANDING_TRIES; t++) {
+            int x = std::min(int(prng.uniform() * WIDTH), WIDTH-1), y = std::min(int(prng.uniform() * HEIGHT), HEIGHT-1);
+            if(grid.type[tileIndex(x,y)] != TileType::Soil || isOccupied(x,y)) continue;
+            spawnPlant(reg, Position{Coord(x),Coord(y)}, m.genes, m.genome, Age{TickStamp(tick), TickStamp(m.maxAge)}, Energy{0.5f});
+            break;
+        }
+    }
+}
+
+// What a domain reports to the coordinator each tick: its counters, then the
+// energy sum and plant count of each of its chunks so the coordinator can
+// merge them in chunk order exactly like a single process.
+struct DomainStats { ull grassAlive, energyDeaths, waterDeaths, oldAgeDeaths, fireDeaths, herbivores; };
+
+static std::string hashPath; // --hash: per-tick state hash file, off when empty
+static bool binaryPlants = false; // --binary: grass_states.bin instead of .csv
+static int checkpointInterval = 0; // --checkpoint N: component snapshot every N ticks, off when 0
+static bool geneStats = false;     // --gene-stats: per-tick distributions to gene_stats.csv
+
+// Checkpoint: every plant's components in tile order and every herbivore in
+// id order, as binary tables in checkpoint_<tick>[.<domain>].bin.
+struct PlantState { Position pos; Age age; Energy energy; Genes genes; Genome genome; };
+template<> struct Schema<PlantState> {
+    static constexpr auto fields = std::make_tuple(
+        field("pos", &PlantState::pos), field("age", &PlantState::age), field("energy", &PlantState::energy),
+        field("genes", &PlantState::genes), field("genome", &PlantState::genome));
+};
+
+void writeCheckpoint(int tick, entt::registry &reg) {
+    static std::vector<PlantState> plants;
+    static std::vector<Herbivore> herd;
+    Plants store(reg);
+    plants.clear();
+    for(int ti=domain.y0*WIDTH; ti<domain.y1*WIDTH; ti++)
+        if(occupant[ti] != entt::null)
+            plants.push_back(PlantState{tilePosition(ti), store.age(ti), store.energy(ti), store.genes(ti), store.genome(ti)});
+    herd.clear();
+    reg.view<Herbivore>().each([](const Herbivore &h){ herd.push_back(h); });
+    std::sort(herd.begin(), herd.end(), [](const Herbivore &a, const Herbivore &b){ return a.id < b.id; });
+
+    std::ofstream out("checkpoint_" + std::to_string(tick) + (domain.split() ? "." + std::to_string(domain.rank) : "") + ".bin",
+                      std::ios::binary);
+    out << "# TICK=" << tick << "\n";
+    writeTable(out, "plants", plants);
+    writeTable(out, "herbivores", herd);
+}
+
+// Simulates the domain set up in `domain` (the whole map unless decomposed).
+int runWorld() {
     entt::registry reg;
-    generateWorld(42);
+    generateWorld(42 + island.index);
+    rng.seed(12345 + island.index);
+    weatherRng.seed(777 + island.index);
     seedGrass(reg);
-    Serializer ser;
+    seedHerbivores(reg);
+    std::string ext = binaryPlants ? ".bin" : ".csv";
+    Serializer ser(domain.split() ? "grass_states." + std::to_string(domain.rank) + ext : "grass_states" + ext,
+                   !domain.split(), binaryPlants);
 
     // pre-allocated buffers
-    std::vector<entt::entity> toKill;
-    std::vector<std::tuple<Position, Genes, Age, Energy>> births;
+    std::vector<int> toKill; // tiles of the plants dying this tick
+    std::vector<Birth> births;
     
     toKill.reserve(WIDTH * HEIGHT / 2);
     births.reserve(WIDTH * HEIGHT / 2);
+#ifndef ECOSIM_COMPACT_PLANTS
     entityPool.reserve(WIDTH * HEIGHT);
+#endif
     
 
 
     
-    // Main loop
-    for(int tick=0; tick<MAX_TICKS; tick++){
+    // per-chunk partial stats, merged in chunk order so totals do not
+    // depend on scheduling
+    struct PlantStats { ull energyDeaths = 0, waterDeaths = 0, oldAgeDeaths = 0; EnergySum sum = 0.0f; int count = 0; };
+    std::vector<PlantStats> chunkStats;
+    // --gene-stats: per-thread distributions, summed into tickDists
+    std::vector<PlantDistributions> threadDists;
+    PlantDistributions tickDists;
+    // chunk-local death and seed lists: a chunk is run by one job, so they
+    // fill without locks and concatenate in chunk order into toKill/births
+    std::vector<std::vector<int>>   chunkKills(CHUNKS_X*CHUNKS_Y);
+    std::vector<std::vector<Birth>> chunkBirths(CHUNKS_X*CHUNKS_Y);
+    std::vector<entt::entity> dying;   // entity of each toKill tile
+    std::vector<entt::entity> newborn; // entity of each winning seed
+    ChunkBalancer plantBalance;
+    
+    // Tick systems in declaration order. Each declares what it reads and
+    // writes and the scheduler overlaps the ones that do not conflict.
+    // Systems that talk to neighbouring domains also write RES_COMM.
+    const uint32_t comm = domain.split() ? uint32_t(RES_COMM) : 0u;
+    Scheduler sched;
+    sched.add({"canopy", RES_PLANTS, RES_CANOPY | comm, [&](int){ buildCanopy(reg); }});
+
+    sched.add({"plants", RES_CANOPY,
+               RES_PLANTS | RES_WATER | RES_NUTRIENT | RES_LITTER | RES_COMMIT | RES_COUNTERS | comm,
+               [&](int tick){
         toKill.clear();
         births.clear();
+        exchangeOccupancy();
 
-        // cached view
-        auto viewAlive = reg.view<Position, Age, Energy, Genes>(entt::exclude<Dead>);
+        Plants plants(reg);
 
         // variables for loop
         float sunI = sunlight(tick);
-        float sum = 0.0f; 
+        EnergySum sum = 0.0f;
         int count = 0;
+        chunkStats.assign(CHUNKS_X*CHUNKS_Y, PlantStats{});
+        if(geneStats) threadDists.assign(jobs.size(), PlantDistributions{});
+
+        // primary loop of living grass, in load-balanced chunk ranges. Plants
+        // are found through the occupancy grid, so a chunk only walks its own
+        // tiles and the random draws come from (tick, tile) rather than a
+        // shared engine.
+        plantBalance.run([&](int c){
+          PlantStats &st = chunkStats[c];
+          auto &kills = chunkKills[c];
+          auto &seeds = chunkBirths[c];
+          kills.clear(); seeds.clear();
+          ChunkRect r = chunkRect(c);
+          for(int cy=r.y0; cy<r.y1; cy++) for(int cx=r.x0; cx<r.x1; cx++){
+            int ti = tileIndex(cx,cy);
+            if(occupant[ti] == entt::null) continue;
+            Age &age = plants.age(ti); Energy &en = plants.energy(ti); Genes &g = plants.genes(ti);
+            HashRng prng{uint64_t(tick), uint64_t(ti)};
 
-        // primary view loop of living grass. 
-        viewAlive.each([&](auto entity, auto &pos, auto &age, auto &en, auto &g){
-            // Energy Update
-            en.value += sunI * g.sunlightEff * 0.1f;
-            Tile &t = at(pos.x,pos.y);
-            float takenW = std::min(t.water, g.waterEff * 0.05f);
-            t.water  -= takenW; en.value += takenW;
-            float takenN = std::min(t.nutrient, g.nutrientEff * 0.05f);
-            t.nutrient -= takenN; en.value += takenN;
+            // Energy Update, at Quantity precision, stored at plant precision
+            Quantity grown = Quantity(en.value);
+            grown += sunI * lightShare(cx, cy) * g.sunlightEff * 0.1f;
+            Quantity &water = grid.water[ti], &nutrient = grid.nutrient[ti];
+            Quantity takenW = std::min(water, Quantity(g.waterEff * 0.05f));
+            water  -= takenW; grown += takenW;
+            Quantity takenN = std::min(nutrient, Quantity(g.nutrientEff * 0.05f));
+            nutrient -= takenN; grown += takenN;
+            en.value = PlantEnergy(grown);
             
             // grow, age, kill
-            count++; sum += en.value; age.age++;
-            if(t.water <= 0.0f) {
-                waterDeaths++; t.nutrient += std::max(en.value, 0.5f);
-                toKill.push_back(entity);
+            float energy = float(en.value);
+            int years = ageAt(age, tick);
+            st.count++; st.sum += EnergySum(en.value);
+            if(geneStats) threadDists[jobs.worker()].add(energy, years, g, plants.genome(ti));
+            float remains = 0.0f;
+            if(water <= 0.0f) {
+                st.waterDeaths++; remains = std::max(energy, 0.5f);
             } else if(en.value <= 0.2f) {
-                energyDeaths++; t.nutrient += std::max(en.value, 1.0f);
-                toKill.push_back(entity);
-            } else if(age.age >= age.maxAge) {
-                oldAgeDeaths++; t.nutrient += std::max(en.value, 1.0f);
-                toKill.push_back(entity);
+                st.energyDeaths++; remains = std::max(energy, 1.0f);
+            } else if(years >= age.maxAge) {
+                st.oldAgeDeaths++; remains = std::max(energy, 1.0f);
+            }
+            if(remains > 0.0f) {
+                depositLitter(ti, remains, plants.genome(ti).decayRate);
+                kills.push_back(ti);
             }
             
 
             // reproduction: reuse pooled entities if available
             if(grassAlive < WIDTH * HEIGHT){
-                if(age.age >= MATURITY_AGE_SCALE * age.maxAge && en.value >= REPRODUCE_ENERGY){
-                    int dx = int(uni(rng)*3)-1, dy = int(uni(rng)*3)-1;
-                    int nx = pos.x + dx, ny = pos.y + dy;
+                if(years >= MATURITY_AGE_SCALE * age.maxAge && en.value >= REPRODUCE_ENERGY){
+                    int dx = int(prng.uniform()*3)-1, dy = int(prng.uniform()*3)-1;
+                    int nx = cx + dx, ny = cy + dy;
                     if(nx>=0 && nx<WIDTH && ny>=0 && ny<HEIGHT
-                       && at(nx,ny).type==TileType::Soil && !isOccupied(nx,ny)){
+                       && grid.type[tileIndex(nx,ny)]==TileType::Soil && !isOccupied(nx,ny)){
         
                         Genes ng = g; 
-                        ng.sunlightEff += gauss(rng);
-                        ng.waterEff    += gauss(rng);
-                        ng.nutrientEff += gauss(rng);
-                        ng.decayRate   += gauss(rng)*0.02f;
+                        Genome ngm = plants.genome(ti);
+                        mutateTraits(ng, ngm, [&]{ return prng.gauss(MUTATION_STDDEV); });
+                        if(ngm.generation < std::numeric_limits<Generation>::max()) ngm.generation++;
                         int parentMax = age.maxAge;
-                        Position newPos{nx,ny};
-                        Age newAge{0, std::max(10, int(parentMax + gauss(rng)*10+0.1))};
+                        Position newPos{Coord(nx),Coord(ny)};
+                        Age newAge{TickStamp(tick), TickStamp(std::max(10, int(parentMax + prng.gauss(MUTATION_STDDEV)*10+0.1)))};
                         Energy newEnergy{0.5f};
-                        births.emplace_back(newPos,ng,newAge,newEnergy);
+                        uint64_t key = claimKey(tick, uint32_t(ti));
+                        claimTile(tileIndex(nx,ny), key);
+                        seeds.push_back(Birth{key,newPos,ng,ngm,newAge,newEnergy});
                         en.value *= 0.1f;
                     }
                 }
             }     
+          }
         });
-
-        // mark dead and pool
-        for(auto e : toKill){
-            reg.emplace<Dead>(e);        // now marking it dead
-            auto &pos = reg.get<Position>(e);
-            clearOccupied(pos.x,pos.y);
-            auto &d = reg.get<Dead>(e);
-            d.dead = true;
-            grassAlive--;
-            entityPool.push_back(e);
-        }
-
-        // produce new grass
-        for (auto b : births) {
-            entt::entity e2;
-            if(!entityPool.empty()){
-                e2 = entityPool.back(); entityPool.pop_back();
-                reg.remove<Dead>(e2);
-                reg.replace<Position>(e2, std::get<0>(b));
-                reg.replace<Genes>(e2, std::get<1>(b));
-                reg.replace<Age>(e2, std::get<2>(b));
-                reg.replace<Energy>(e2, std::get<3>(b));
-            } else {
-                e2 = reg.create();
-                reg.emplace<Position>(e2, std::get<0>(b));
-                reg.emplace<Genes>(e2, std::get<1>(b));
-                reg.emplace<Age>(e2, std::get<2>(b));
-                reg.emplace<Energy>(e2, std::get<3>(b));
-            }
-            setOccupied(std::get<0>(b).x,std::get<0>(b).y);
-            grassAlive++;
+        for(auto &st : chunkStats){
+            energyDeaths += st.energyDeaths; waterDeaths += st.waterDeaths; oldAgeDeaths += st.oldAgeDeaths;
+            sum += st.sum; count += st.count;
         }
-
-        // environment systems
-        // rain system
-        if(tick % RAIN_INTERVAL == 0){
-            for(auto &t : grid) if(t.type==TileType::Soil) t.water += RAIN_AMOUNT;
+        if(geneStats) {
+            tickDists = PlantDistributions{};
+            for(auto &d : threadDists) tickDists += d;
+        }
+        for(int c=domain.c0; c<domain.c1; c++) {
+            toKill.insert(toKill.end(), chunkKills[c].begin(), chunkKills[c].end());
+            births.insert(births.end(), chunkBirths[c].begin(), chunkBirths[c].end());
         }
 
         // stats
-        avgGrassEnergy = count ? sum/count : 0.0f;
+        avgGrassEnergy = count ? float(sum)/count : 0.0f;
+        if(domain.split()) routeBirths(births);
+    }});
 
-        
+    // mark dead and pool, in chunk order so entity reuse is the same for
+    // any thread count
+    sched.add({"deaths", 0, RES_PLANTS | RES_COMMIT | RES_COUNTERS, [&](int){
+        dying.resize(toKill.size());
+        jobs.parallelFor(0, int(toKill.size()), BIRTH_BLOCK, [&](int lo, int hi){
+            for(int k=lo; k<hi; k++) {
+                dying[k] = occupant[toKill[k]];
+                occupant[toKill[k]] = entt::null;
+            }
+        });
+        freePlants(reg, dying.begin(), dying.end());
+        grassAlive -= dying.size();
+    }});
+
+    // produce new grass: only the winning claim on each tile is born,
+    // the losing seeds are lost. Winners get their plant ids in birth order
+    // from allocatePlants; components and occupancy are then written in
+    // parallel blocks. Every claimed tile has exactly one winner, which
+    // releases the claim.
+    sched.add({"births", 0, RES_PLANTS | RES_COMMIT | RES_COUNTERS, [&](int){
+        births.erase(std::remove_if(births.begin(), births.end(), [](const Birth &b){
+            return !wonClaim(tileIndex(b.pos.x, b.pos.y), b.key);
+        }), births.end());
+        size_t n = births.size();
+        newborn.clear();
+        allocatePlants(reg, newborn, n);
+        Plants plants(reg);
+        jobs.parallelFor(0, int(n), BIRTH_BLOCK, [&](int lo, int hi){
+            for(int k=lo; k<hi; k++) {
+                const Birth &b = births[k];
+                int ti = tileIndex(b.pos.x, b.pos.y);
+                plants.place(ti, newborn[k], b.genes, b.genome, b.age, b.energy);
+                releaseClaim(ti);
+            }
+        });
+        grassAlive += n;
+    }});
+
+    // seeds arriving from other islands
+    sched.add({"migration", 0, RES_PLANTS | RES_COMM, [&](int tick){ migrate(tick, reg); }});
+
+    // disturbance systems
+    sched.add({"fire", RES_WATER, RES_PLANTS | RES_LITTER | RES_FIRE | RES_WEATHER | RES_COUNTERS | comm,
+               [&](int tick){ fireStep(tick, reg); }});
+
+    // consumer systems
+    sched.add({"herbivores", RES_CANOPY, RES_PLANTS | RES_HERBIVORES | RES_FLOW | comm,
+               [&](int tick){ herbivoreStep(tick, reg); }});
+
+    // environment systems
+    sched.add({"hydrology", 0, RES_WATER | comm, [](int){ hydrologyStep(); }});
+    sched.add({"decomposition", 0, RES_LITTER | RES_NUTRIENT, [](int){ decomposeLitter(); }});
+    sched.add({"nutrients", 0, RES_NUTRIENT | comm, [](int tick){ nutrientStep(tick); }});
+    sched.add({"rain", 0, RES_WEATHER | RES_WATER, [](int tick){ updateStorms(tick); applyStorms(); }});
+
+    // state hashes, taken before output resets the counters
+    std::unique_ptr<StateHasher> hasher;
+    if(!hashPath.empty()) {
+        hasher.reset(new StateHasher(hashPath));
+        sched.add({"hash", RES_PLANTS | RES_HERBIVORES | RES_WATER | RES_NUTRIENT | RES_LITTER | RES_FLOW
+                           | RES_FIRE | RES_WEATHER | RES_COUNTERS, RES_OUTPUT,
+                   [&](int tick){ hasher->record(tick, reg); }});
+    }
+
+    AggregateWriter aggregates(domain.split() ? "aggregates." + std::to_string(domain.rank) + ".csv" : "aggregates.csv");
+    sched.add({"aggregates", RES_PLANTS | RES_WATER | RES_NUTRIENT, RES_OUTPUT, [&](int tick){
+        if(tick % SAVE_INTERVAL == 0) aggregates.record(tick, reg);
+    }});
+
+    if(checkpointInterval > 0)
+        sched.add({"checkpoint", RES_PLANTS | RES_HERBIVORES, RES_OUTPUT, [&](int tick){
+            if(tick % checkpointInterval == 0) writeCheckpoint(tick, reg);
+        }});
+
+    // output; a domain sends its stats to the coordinator instead
+    std::unique_ptr<DistributionWriter> distOut;
+    if(geneStats && !domain.split()) distOut.reset(new DistributionWriter("gene_stats.csv"));
+    sched.add({"output", RES_PLANTS | RES_HERBIVORES, RES_COUNTERS | RES_OUTPUT | comm, [&](int tick){
+        if(domain.split()) {
+            DomainStats ds{grassAlive, energyDeaths, waterDeaths, oldAgeDeaths, fireDeaths, herbivoresAlive};
+            int chunks = domain.c1 - domain.c0;
+            size_t dists = geneStats ? sizeof tickDists : 0;
+            std::vector<char> msg(sizeof ds + dists + chunks * (sizeof(EnergySum) + sizeof(int)));
+            char *p = msg.data();
+            std::memcpy(p, &ds, sizeof ds); p += sizeof ds;
+            std::memcpy(p, &tickDists, dists); p += dists;
+            for(int c=domain.c0; c<domain.c1; c++) { std::memcpy(p, &chunkStats[c].sum, sizeof(EnergySum)); p += sizeof(EnergySum); }
+            for(int c=domain.c0; c<domain.c1; c++) { std::memcpy(p, &chunkStats[c].count, sizeof(int)); p += sizeof(int); }
+            domain.net->send(domain.count, msg);
+        }
+        if(distOut) distOut->record(tick, tickDists);
         ser.saveTick(tick, grassAlive, reg);
         if(tick % SAVE_INTERVAL == 0) {
                 ser.saveStatsCache();   
         }
-        if(tick % SAVE_INTERVAL*10 == 0) std::cout << tick << "\n";
+    }});
+
+    // Main loop
+    for(int tick=0; tick<MAX_TICKS; tick++){
+        sched.run(tick);
+        if(!domain.split() && island.index == 0 && tick % SAVE_INTERVAL*10 == 0) std::cout << tick << "\n";
+    }
+    ser.finish(); // final cache flush
+    if(!domain.split() && island.index == 0)
+        std::cout << "Simulation complete. Data -> grass_states" << ext << ", world_state.csv, simulation_stats.csv\n";
+    return 0;
+}
 
+// Coordinator of a decomposed run: merges the domains' per-tick reports into
+// the same stats rows a single process writes, and writes the world file.
+int coordinate() {
+    generateWorld(42);
+    Serializer ser("", true);
+    std::unique_ptr<DistributionWriter> distOut;
+    if(geneStats) distOut.reset(new DistributionWriter("gene_stats.csv"));
+    std::vector<char> msg;
+    for(int tick=0; tick<MAX_TICKS; tick++) {
+        DomainStats total{};
+        PlantDistributions dists;
+        EnergySum sum = 0.0f;
+        int count = 0;
+        for(int r=0; r<domain.count; r++) {
+            domain.net->recv(r, msg);
+            DomainStats ds;
+            const char *p = msg.data();
+            std::memcpy(&ds, p, sizeof ds); p += sizeof ds;
+            if(geneStats) {
+                static PlantDistributions part;
+                std::memcpy(&part, p, sizeof part); p += sizeof part;
+                dists += part;
+            }
+            int chunks = int((msg.data() + msg.size() - p) / (sizeof(EnergySum) + sizeof(int)));
+            for(int k=0; k<chunks; k++) {
+                EnergySum s; int c;
+                std::memcpy(&s, p + k*sizeof(EnergySum), sizeof s);
+                std::memcpy(&c, p + chunks*sizeof(EnergySum) + k*sizeof(int), sizeof c);
+                sum += s; count += c;
+            }
+            total.grassAlive += ds.grassAlive;     total.energyDeaths += ds.energyDeaths;
+            total.waterDeaths += ds.waterDeaths;   total.oldAgeDeaths += ds.oldAgeDeaths;
+            total.fireDeaths += ds.fireDeaths;     total.herbivores += ds.herbivores;
+        }
+        ser.recordStats(tick, int(total.grassAlive), total.energyDeaths, total.waterDeaths, total.oldAgeDeaths,
+                        total.fireDeaths, count ? float(sum)/count : 0.0f, total.herbivores);
+        if(distOut) distOut->record(tick, dists);
+        if(tick % SAVE_INTERVAL == 0) ser.saveStatsCache();
+        if(tick % SAVE_INTERVAL*10 == 0) std::cout << tick << "\n";
     }
-    ser.saveStatsCache(); // final cache flush
-    std::cout << "Simulation complete. Data -> grass_states.csv, world_state.csv, simulation_stats.csv\n";
+    ser.finish();
+    std::cout << "Simulation complete. Data -> grass_states.<domain>.csv, world_state.csv, simulation_stats.csv\n";
     return 0;
 }
+
+// Forks one process per domain plus this one as coordinator, connected by
+// the chosen transport, and waits for the domains to finish.
+int runDecomposed(int domains, const std::string &transport, unsigned threads) {
+#if defined(__unix__)
+    int n = std::clamp(domains, 1, CHUNKS_Y);
+    std::unique_ptr<Transport> net;
+    if(transport == "socket")   net.reset(new SocketTransport(n + 1));
+    else if(transport == "shm") net.reset(new ShmTransport(n + 1));
+    else { std::cerr << "unknown transport " << transport << " (shm or socket)\n"; return 1; }
+    std::cout.flush();
+    std::vector<pid_t> children;
+    for(int r=0; r<n; r++) {
+        pid_t pid = fork();
+        if(pid < 0) { std::perror("fork"); return 1; }
+        if(pid == 0) {
+            net->bind(r);
+            assignDomain(r, n, net.get());
+            jobs.start(threads);
+            std::exit(runWorld());
+        }
+        net->track(r, pid);
+        children.push_back(pid);
+    }
+    net->bind(n);
+    domain.rank = n; domain.count = n; domain.net = net.get();
+    jobs.start(1);
+    int rc = coordinate();
+    for(pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) rc = 1;
+    }
+    return rc;
+#else
+    (void)domains; (void)transport; (void)threads;
+    std::cerr << "--domains needs a POSIX system\n";
+    return 1;
+#endif
+}
+
+// Forks one process per island, each writing its files into island<i>/,
+// and waits for them. Island i uses terrain seed 42+i.
+int runIslands(int count, unsigned threads) {
+#if defined(__unix__)
+    ShmTransport net(count);
+    std::cout.flush();
+    std::vector<pid_t> children;
+    for(int i=0; i<count; i++) {
+        pid_t pid = fork();
+        if(pid < 0) { std::perror("fork"); return 1; }
+        if(pid == 0) {
+            std::string dir = "island" + std::to_string(i);
+            mkdir(dir.c_str(), 0755);
+            if(chdir(dir.c_str()) != 0) { std::perror(dir.c_str()); std::exit(1); }
+            net.bind(i);
+            island.index = i; island.count = count; island.net = &net;
+            jobs.start(threads);
+            std::exit(runWorld());
+        }
+        net.track(i, pid);
+    }
+    // reap islands as they exit, so the others notice a dead one at once
+    int rc = 0;
+    for(int i=0; i<count; i++) {
+        int status = 0;
+        if(waitpid(-1, &status, 0) < 0) { std::perror("waitpid"); return 1; }
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) rc = 1;
+    }
+    return rc;
+#else
+    (void)count; (void)threads;
+    std::cerr << "--islands needs a POSIX system\n";
+    return 1;
+#endif
+}
+
+// usage: sim [--threads N] [--hash FILE] [--domains N [--transport shm|socket] | --islands N]
+//        sim --compare A B
+int main(int argc, char **argv){
+    if(argc == 4 && std::string(argv[1]) == "--compare") return compareHashes(argv[2], argv[3]);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    int domains = 1, islands = 1;
+    std::string transport = "shm";
+    bool ok = true;
+    for(int i=1; i<argc && ok; i++) {
+        std::string arg = argv[i];
+        if(arg == "--threads" && i+1 < argc)        threads = unsigned(std::max(1, std::atoi(argv[++i])));
+        else if(arg == "--domains" && i+1 < argc)   domains = std::atoi(argv[++i]);
+        else if(arg == "--transport" && i+1 < argc) transport = argv[++i];
+        else if(arg == "--islands" && i+1 < argc)   islands = std::atoi(argv[++i]);
+        else if(arg == "--hash" && i+1 < argc)      hashPath = argv[++i];
+        else if(arg == "--binary")                  binaryPlants = true;
+        else if(arg == "--gene-stats")              geneStats = true;
+        else if(arg == "--columns" && i+1 < argc)   ok = parseColumns(argv[++i], outputConfig);
+        else if(arg == "--region" && i+1 < argc)    ok = parseRegion(argv[++i], outputConfig);
+        else if(arg == "--region-mask" && i+1 < argc) ok = loadRegionMask(argv[++i], outputConfig);
+        else if((arg == "--sample" || arg == "--track") && i+1 < argc) {
+            ok = !outputConfig.sample && (outputConfig.sample = std::atoi(argv[++i])) > 0;
+            outputConfig.track = arg == "--track";
+        }
+        else if(arg == "--checkpoint" && i+1 < argc) checkpointInterval = std::atoi(argv[++i]);
+        else { domains = islands = 0; break; }
+    }
+    // hashes cover the whole map, which no single domain holds
+    if(!ok || domains < 1 || islands < 1 || (domains > 1 && islands > 1) || (domains > 1 && !hashPath.empty())) {
+        std::cerr << "usage: " << argv[0] << " [--threads N] [--hash FILE] [--binary] [--checkpoint N] [--gene-stats]\n"
+                  << "           [--columns a,b,..] [--region x0,y0,x1,y1] [--region-mask FILE] [--sample K | --track K]\n"
+                  << "           [--domains N [--transport shm|socket] | --islands N]\n"
+                  << "       " << argv[0] << " --compare A B\n";
+        return 1;
+    }
+    if(islands > 1) return runIslands(islands, threads);
+    if(domains > 1) return runDecomposed(domains, transport, threads);
+    jobs.start(threads);
+    return runWorld();
+}
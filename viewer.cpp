@@ -9,6 +9,9 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
 
 // Simple 2D integer point
 struct Vec2i { int x, y; };
@@ -21,51 +24,130 @@ static std::string trim(const std::string &s) {
     return (start==std::string::npos) ? "" : s.substr(start, end-start+1);
 }
 
-int main() {
-    // Load vegetation frames
-    std::ifstream vegFile("grass_states.csv");
-    if (!vegFile.is_open()) {
-        std::cerr << "Error: could not open grass_states.csv\n";
-        return 1;
-    }
+// Split a csv line into its fields
+static std::vector<std::string> splitCsv(const std::string &line) {
+    std::vector<std::string> out;
+    std::stringstream ss(line);
+    std::string tok;
+    while (std::getline(ss, tok, ',')) out.push_back(trim(tok));
+    return out;
+}
+
+// Read an integer field of a binary table row given its type tag (i4, u2, ...)
+static long long readInt(const char *p, const std::string &type) {
+    if (type == "i4") { int32_t v;  std::memcpy(&v, p, 4); return v; }
+    if (type == "u4") { uint32_t v; std::memcpy(&v, p, 4); return v; }
+    if (type == "i2") { int16_t v;  std::memcpy(&v, p, 2); return v; }
+    if (type == "u2") { uint16_t v; std::memcpy(&v, p, 2); return v; }
+    if (type == "i8") { int64_t v;  std::memcpy(&v, p, 8); return v; }
+    if (type == "u8") { uint64_t v; std::memcpy(&v, p, 8); return (long long)v; }
+    return 0;
+}
+
+// Plant positions per tick, read from grass_states.csv or, for a --binary
+// run, grass_states.bin. Both name their columns (csv header, binary #field
+// lines), so only tick, x and y are looked up and other columns may change.
+// Plants go straight into their frame; the settings lines come first in both.
+struct VegData {
     int WIDTH=0, HEIGHT=0, SAVE_INTERVAL=0, MAX_TICKS=0;
-    std::string line;
-    while (std::getline(vegFile, line)) {
-        if (line.rfind("#", 0) == 0) {
-            auto eq = line.find('=');
-            if (eq != std::string::npos) {
-                std::string key = line.substr(2, eq-2);
-                int val = std::stoi(line.substr(eq+1));
-                if      (key == "WIDTH")         WIDTH = val;
-                else if (key == "HEIGHT")        HEIGHT = val;
-                else if (key == "SAVE_INTERVAL") SAVE_INTERVAL = val;
-                else if (key == "MAX_TICKS")     MAX_TICKS = val;
+    std::vector<std::vector<Vec2i>> frames; // plant positions per SAVE_INTERVAL frame
+
+    void add(int tick, int x, int y) {
+        if (SAVE_INTERVAL <= 0) return;
+        if (frames.empty()) frames.resize(std::max(0, MAX_TICKS / SAVE_INTERVAL));
+        int idx = tick / SAVE_INTERVAL;
+        if (idx >= 0 && idx < int(frames.size()))
+            frames[idx].push_back({x, y});
+    }
+
+    void setting(const std::string &line) {
+        auto eq = line.find('=');
+        if (eq == std::string::npos) return;
+        std::string key = line.substr(2, eq-2);
+        int val = std::stoi(line.substr(eq+1));
+        if      (key == "WIDTH")         WIDTH = val;
+        else if (key == "HEIGHT")        HEIGHT = val;
+        else if (key == "SAVE_INTERVAL") SAVE_INTERVAL = val;
+        else if (key == "MAX_TICKS")     MAX_TICKS = val;
+    }
+
+    bool loadCsv(std::istream &in) {
+        std::string line;
+        std::vector<std::string> cols;
+        while (std::getline(in, line)) {
+            if (line.rfind("# ", 0) == 0) setting(line);
+            else if (line.rfind("tick,", 0) == 0) { cols = splitCsv(line); break; }
+        }
+        auto col = [&](const char *name) { return int(std::find(cols.begin(), cols.end(), name) - cols.begin()); };
+        int ct = col("tick"), cx = col("x"), cy = col("y"), n = int(cols.size());
+        if (ct == n || cx == n || cy == n) return false;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            auto f = splitCsv(line);
+            if (int(f.size()) < n) continue;
+            add(std::stoi(f[ct]), std::stoi(f[cx]), std::stoi(f[cy]));
+        }
+        return true;
+    }
+
+    bool loadBinary(std::istream &in) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.rfind("# ", 0) == 0) { setting(line); continue; }
+            if (line.rfind("#table ", 0) != 0) return false;
+            std::stringstream hs(line.substr(7));
+            std::string table;
+            size_t rows = 0, rowBytes = 0;
+            hs >> table >> rows >> rowBytes;
+            struct Col { size_t offset = 0; std::string type; bool seen = false; };
+            Col tick, x, y;
+            while (std::getline(in, line) && line != "#data") {
+                std::stringstream fs(line.substr(7)); // after "#field "
+                std::string name; Col c;
+                fs >> name >> c.offset >> c.type;
+                c.seen = true;
+                if      (name == "tick") tick = c;
+                else if (name == "x")    x = c;
+                else if (name == "y")    y = c;
+            }
+            std::vector<char> data(rows * rowBytes);
+            if (!in.read(data.data(), std::streamsize(data.size()))) return false;
+            if (table != "plants") continue;
+            if (!tick.seen || !x.seen || !y.seen) return false; // written without these --columns
+            for (size_t r = 0; r < rows; r++) {
+                const char *row = data.data() + r * rowBytes;
+                add(int(readInt(row + tick.offset, tick.type)),
+                    int(readInt(row + x.offset, x.type)), int(readInt(row + y.offset, y.type)));
             }
-        } else if (line.rfind("tick,", 0) == 0) {
-            break;
         }
+        return true;
+    }
+};
+
+int main(int argc, char **argv) {
+    // Load vegetation frames: viewer [grass_states.csv | grass_states.bin]
+    std::string vegPath = argc > 1 ? argv[1] : "grass_states.csv";
+    bool binary = vegPath.size() >= 4 && vegPath.compare(vegPath.size() - 4, 4, ".bin") == 0;
+    VegData veg;
+    std::ifstream vegFile(vegPath, binary ? std::ios::binary : std::ios::in);
+    if (!vegFile.is_open()) {
+        std::cerr << "Error: could not open " << vegPath << "\n";
+        return 1;
+    }
+    if (!(binary ? veg.loadBinary(vegFile) : veg.loadCsv(vegFile))) {
+        std::cerr << "Error: could not read plant columns tick, x, y from " << vegPath << "\n";
+        return 1;
     }
+    std::cout << "Loaded " << vegPath << "\n";
+    int WIDTH = veg.WIDTH, HEIGHT = veg.HEIGHT, SAVE_INTERVAL = veg.SAVE_INTERVAL, MAX_TICKS = veg.MAX_TICKS;
     if (!WIDTH || !HEIGHT || !SAVE_INTERVAL || !MAX_TICKS) {
-        std::cerr << "Error: invalid settings in grass_states.csv\n";
+        std::cerr << "Error: invalid settings in " << vegPath << "\n";
         return 1;
     }
     int NUM_FRAMES = MAX_TICKS / SAVE_INTERVAL;
-    std::vector<std::vector<Vec2i>> grassFrames(NUM_FRAMES);
-
-    while (std::getline(vegFile, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string tok;
-        int tick, x, y;
-        std::getline(ss, tok, ','); tick = std::stoi(tok);
-        std::getline(ss, tok, ','); // skip id
-        std::getline(ss, tok, ','); x = std::stoi(tok);
-        std::getline(ss, tok, ','); y = std::stoi(tok);
-        int idx = tick / SAVE_INTERVAL;
-        if (idx >= 0 && idx < NUM_FRAMES)
-            grassFrames[idx].push_back({x, y});
-    }
-    vegFile.close();
+    std::vector<std::vector<Vec2i>> grassFrames = std::move(veg.frames);
+    grassFrames.resize(NUM_FRAMES);
+    std::string line;
 
     // Load water frames
     std::ifstream worldFile("world_state.csv");